@@ -0,0 +1,102 @@
+/*
+ * C interface to punk_dsp::Lifter, the same DSP the plugin runs, for use outside a plugin host
+ * (Python through ctypes/cffi, C analysis pipelines, batch jobs).
+ *
+ * Buffers are always caller-owned and processed in place. Planar buffers are handed to the
+ * Lifter as they are, with no copy. Interleaved buffers go through a scratch buffer that is
+ * allocated in lifter_prepare(), since the Lifter itself works on planar data.
+ *
+ * Blocks of any length can be passed; longer ones than max_block_size are processed in
+ * max_block_size pieces. Processing never allocates or locks, which holds up to
+ * LIFTER_MAX_CHANNELS channels: the buffer views handed to the Lifter allocate from 32 on.
+ *
+ * A handle must not be used from two threads at once. Separate handles are independent.
+ *
+ * Python example:
+ *
+ *   lib = ctypes.CDLL ("libLifterDSP.so")
+ *   lib.lifter_create.restype = ctypes.c_void_p
+ *   handle = lib.lifter_create()
+ *   lib.lifter_prepare (ctypes.c_void_p (handle), ctypes.c_double (48000.0), 4096, 2)
+ *   lib.lifter_set_parameter (ctypes.c_void_p (handle), LIFTER_PARAM_RATIO, ctypes.c_float (6.0))
+ *   frames = numpy.ascontiguousarray (audio, dtype=numpy.float32)   # shape (n, 2)
+ *   lib.lifter_process_interleaved (ctypes.c_void_p (handle), frames.ctypes.data_as (ctypes.c_void_p), 2, len (frames))
+ *   lib.lifter_destroy (ctypes.c_void_p (handle))
+ */
+
+#ifndef LIFTER_H
+#define LIFTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined (LIFTER_SHARED)
+    #if defined (_WIN32)
+        #if defined (LIFTER_BUILDING_LIBRARY)
+            #define LIFTER_API __declspec (dllexport)
+        #else
+            #define LIFTER_API __declspec (dllimport)
+        #endif
+    #else
+        #define LIFTER_API __attribute__ ((visibility ("default")))
+    #endif
+#else
+    #define LIFTER_API
+#endif
+
+typedef struct lifter lifter;
+
+/* Largest num_channels lifter_prepare() accepts */
+#define LIFTER_MAX_CHANNELS 31
+
+typedef enum lifter_status
+{
+    LIFTER_OK = 0,
+    LIFTER_ERROR_INVALID_ARGUMENT = -1,  /* Null pointer, out of range count or non-finite value */
+    LIFTER_ERROR_NOT_PREPARED = -2,      /* lifter_prepare() has not succeeded yet */
+    LIFTER_ERROR_TOO_MANY_CHANNELS = -3, /* More than LIFTER_MAX_CHANNELS, or than the handle was prepared for */
+    LIFTER_ERROR_OUT_OF_MEMORY = -4
+} lifter_status;
+
+/* Same parameters, units and ranges as the plugin */
+typedef enum lifter_parameter
+{
+    LIFTER_PARAM_RATIO = 0,        /* 1 to 100 (:1), default 4 */
+    LIFTER_PARAM_THRESHOLD = 1,    /* -90 to 0 dB, default -40 */
+    LIFTER_PARAM_KNEE = 2,         /* 1 to 30 dB, default 12 */
+    LIFTER_PARAM_ATTACK = 3,       /* 0.1 to 250 ms, default 15 */
+    LIFTER_PARAM_RELEASE = 4,      /* 5 to 3000 ms, default 60 */
+    LIFTER_PARAM_MAKEUP = 5,       /* -30 to 30 dB, default 0 */
+    LIFTER_PARAM_MIX = 6,          /* 0 to 100 %, default 100 */
+    LIFTER_PARAM_FEED_FORWARD = 7  /* 1 feed-forward, 0 feed-back, default 1 */
+} lifter_parameter;
+
+/* Returns NULL if out of memory */
+LIFTER_API lifter* lifter_create (void);
+LIFTER_API void lifter_destroy (lifter* handle);
+
+/* Allocates everything processing needs. Call again to change the rate, block size or channels. */
+LIFTER_API lifter_status lifter_prepare (lifter* handle, double sample_rate, int max_block_size, int num_channels);
+
+/* Clears the detector state, as at the start of a new file */
+LIFTER_API lifter_status lifter_reset (lifter* handle);
+
+/* Values outside the parameter's range are clamped to it */
+LIFTER_API lifter_status lifter_set_parameter (lifter* handle, lifter_parameter parameter, float value);
+LIFTER_API lifter_status lifter_get_parameter (const lifter* handle, lifter_parameter parameter, float* value);
+
+/* channels[c] points to num_samples samples of channel c */
+LIFTER_API lifter_status lifter_process_planar (lifter* handle, float* const* channels, int num_channels, int num_samples);
+
+/* data holds num_frames frames of num_channels samples each */
+LIFTER_API lifter_status lifter_process_interleaved (lifter* handle, float* data, int num_channels, int num_frames);
+
+/* Gain added at the end of the last processed block, in dB */
+LIFTER_API float lifter_get_gain_addition (const lifter* handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,213 @@
+#include "lifter.h"
+
+#include <juce_dsp/juce_dsp.h>
+#include "punk_dsp/punk_dsp.h"
+#include "ParameterRanges.h"
+
+namespace
+{
+    using ParameterRanges::Range;
+
+    // In lifter_parameter order, from the same header the plugin's parameters use
+    constexpr std::array<Range, 8> ranges {{
+        ParameterRanges::ratio,
+        ParameterRanges::thres,
+        ParameterRanges::knee,
+        ParameterRanges::attack,
+        ParameterRanges::release,
+        ParameterRanges::makeup,
+        ParameterRanges::mix,
+        { 0.0f, 1.0f, ParameterRanges::feedForwardDefault ? 1.0f : 0.0f }
+    }};
+
+    static_assert (ranges.size() == LIFTER_PARAM_FEED_FORWARD + 1);
+
+    bool isValid (lifter_parameter parameter)
+    {
+        return parameter >= LIFTER_PARAM_RATIO && parameter <= LIFTER_PARAM_FEED_FORWARD;
+    }
+}
+
+struct lifter
+{
+    void pushParameter (lifter_parameter parameter)
+    {
+        const auto value = values[(size_t) parameter];
+
+        switch (parameter)
+        {
+            case LIFTER_PARAM_RATIO:        dsp.updateRatio (value); break;
+            case LIFTER_PARAM_THRESHOLD:    dsp.updateRange (value); break;
+            case LIFTER_PARAM_KNEE:         dsp.updateKnee (value); break;
+            case LIFTER_PARAM_ATTACK:       dsp.updateAttack (value); break;
+            case LIFTER_PARAM_RELEASE:      dsp.updateRelease (value); break;
+            case LIFTER_PARAM_MAKEUP:       dsp.updateMakeUp (value); break;
+            case LIFTER_PARAM_MIX:          dsp.updateMix (value); break;
+            case LIFTER_PARAM_FEED_FORWARD: dsp.updateFeedForward (value >= 0.5f); break;
+        }
+    }
+
+    void pushAllParameters()
+    {
+        for (int p = LIFTER_PARAM_RATIO; p <= LIFTER_PARAM_FEED_FORWARD; ++p)
+            pushParameter (static_cast<lifter_parameter> (p));
+    }
+
+    // Caller memory is wrapped, never copied. Blocks longer than prepared run in pieces.
+    void process (float* const* channels, int numChannels, int numSamples)
+    {
+        juce::ScopedNoDenormals noDenormals;
+
+        for (int start = 0; start < numSamples; start += maxBlockSize)
+        {
+            juce::AudioBuffer<float> block (channels, numChannels, start, juce::jmin (maxBlockSize, numSamples - start));
+            dsp.process (block);
+        }
+
+        gainAddition = dsp.getGainAddition();
+    }
+
+    punk_dsp::Lifter dsp;
+    std::array<float, ranges.size()> values {};
+    juce::dsp::ProcessSpec spec {};
+    int maxBlockSize = 0;
+    bool prepared = false;
+
+    // Read back after each process call, so the getter can take a const handle
+    float gainAddition = 0.0f;
+
+    // Planar copy of an interleaved block, sized in lifter_prepare()
+    juce::AudioBuffer<float> deinterleaved;
+};
+
+//==============================================================================
+lifter* lifter_create (void)
+{
+    try
+    {
+        auto* handle = new lifter();
+
+        for (size_t p = 0; p < ranges.size(); ++p)
+            handle->values[p] = ranges[p].defaultValue;
+
+        return handle;
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void lifter_destroy (lifter* handle)
+{
+    delete handle;
+}
+
+lifter_status lifter_prepare (lifter* handle, double sample_rate, int max_block_size, int num_channels)
+{
+    if (handle == nullptr || ! (sample_rate > 0.0) || max_block_size <= 0 || num_channels <= 0)
+        return LIFTER_ERROR_INVALID_ARGUMENT;
+
+    if (num_channels > LIFTER_MAX_CHANNELS)
+        return LIFTER_ERROR_TOO_MANY_CHANNELS;
+
+    try
+    {
+        handle->prepared = false;
+        handle->spec = { sample_rate, (juce::uint32) max_block_size, (juce::uint32) num_channels };
+        handle->maxBlockSize = max_block_size;
+        handle->deinterleaved.setSize (num_channels, max_block_size);
+
+        handle->dsp.prepare (handle->spec);
+        handle->pushAllParameters();
+        handle->gainAddition = 0.0f;
+        handle->prepared = true;
+        return LIFTER_OK;
+    }
+    catch (...)
+    {
+        return LIFTER_ERROR_OUT_OF_MEMORY;
+    }
+}
+
+lifter_status lifter_reset (lifter* handle)
+{
+    if (handle == nullptr)
+        return LIFTER_ERROR_INVALID_ARGUMENT;
+
+    if (! handle->prepared)
+        return LIFTER_ERROR_NOT_PREPARED;
+
+    // The Lifter starts from a clean detector when prepared, with the same sizes nothing is reallocated
+    handle->dsp.prepare (handle->spec);
+    handle->pushAllParameters();
+    handle->gainAddition = 0.0f;
+    return LIFTER_OK;
+}
+
+lifter_status lifter_set_parameter (lifter* handle, lifter_parameter parameter, float value)
+{
+    if (handle == nullptr || ! isValid (parameter) || ! std::isfinite (value))
+        return LIFTER_ERROR_INVALID_ARGUMENT;
+
+    const auto& range = ranges[(size_t) parameter];
+    handle->values[(size_t) parameter] = juce::jlimit (range.min, range.max, value);
+    handle->pushParameter (parameter);
+    return LIFTER_OK;
+}
+
+lifter_status lifter_get_parameter (const lifter* handle, lifter_parameter parameter, float* value)
+{
+    if (handle == nullptr || ! isValid (parameter) || value == nullptr)
+        return LIFTER_ERROR_INVALID_ARGUMENT;
+
+    *value = handle->values[(size_t) parameter];
+    return LIFTER_OK;
+}
+
+lifter_status lifter_process_planar (lifter* handle, float* const* channels, int num_channels, int num_samples)
+{
+    if (handle == nullptr || channels == nullptr || num_channels <= 0 || num_samples < 0)
+        return LIFTER_ERROR_INVALID_ARGUMENT;
+
+    if (! handle->prepared)
+        return LIFTER_ERROR_NOT_PREPARED;
+
+    if (num_channels > (int) handle->spec.numChannels)
+        return LIFTER_ERROR_TOO_MANY_CHANNELS;
+
+    handle->process (channels, num_channels, num_samples);
+    return LIFTER_OK;
+}
+
+lifter_status lifter_process_interleaved (lifter* handle, float* data, int num_channels, int num_frames)
+{
+    if (handle == nullptr || data == nullptr || num_channels <= 0 || num_frames < 0)
+        return LIFTER_ERROR_INVALID_ARGUMENT;
+
+    if (! handle->prepared)
+        return LIFTER_ERROR_NOT_PREPARED;
+
+    if (num_channels > (int) handle->spec.numChannels)
+        return LIFTER_ERROR_TOO_MANY_CHANNELS;
+
+    // The Lifter is planar, so each prepared-size piece is split out, processed and written back
+    auto& scratch = handle->deinterleaved;
+
+    for (int start = 0; start < num_frames; start += handle->maxBlockSize)
+    {
+        const auto numSamples = juce::jmin (handle->maxBlockSize, num_frames - start);
+        auto* frames = data + (size_t) start * (size_t) num_channels;
+
+        juce::AudioDataConverters::deinterleaveSamples<float> ({ frames, num_channels }, { scratch.getArrayOfWritePointers(), num_channels }, numSamples);
+        handle->process (scratch.getArrayOfWritePointers(), num_channels, numSamples);
+        juce::AudioDataConverters::interleaveSamples<float> ({ scratch.getArrayOfReadPointers(), num_channels }, { frames, num_channels }, numSamples);
+    }
+
+    return LIFTER_OK;
+}
+
+float lifter_get_gain_addition (const lifter* handle)
+{
+    return handle != nullptr ? handle->gainAddition : 0.0f;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+// One low-priority thread per process for work that must stay off the audio thread,
+// such as rebuilding tables. Share it with juce::SharedResourcePointer<BackgroundThread>.
+class BackgroundThread : public juce::TimeSliceThread
+{
+public:
+    BackgroundThread() : juce::TimeSliceThread ("Lifter background")
+    {
+        startThread (juce::Thread::Priority::low);
+    }
+
+    ~BackgroundThread() override
+    {
+        stopThread (1000);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BackgroundThread)
+};
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <bit>
+
+// Per-block timing of one stage of processBlock, for finding the instance that spikes.
+//
+// The audio thread records one duration per block into fixed atomics and a histogram with one
+// row per octave from 64 ns to 1 s, split into 4 equal-width buckets, so recording never
+// allocates or locks.
+// Any other thread can read the stats at any time. They are collected without a lock, so
+// a read may mix two consecutive blocks, which is fine for a diagnostic display.
+//
+// Only built when LIFTER_PROFILING is on (cmake -DLIFTER_PROFILING=ON). Otherwise
+// LIFTER_PROFILE_BLOCK expands to nothing.
+class BlockProfiler
+{
+public:
+    struct Stats
+    {
+        juce::int64 numBlocks = 0;
+        double minNs = 0.0, meanNs = 0.0, p99Ns = 0.0, maxNs = 0.0;
+
+        // Share of the block's real-time budget (block length at the current sample rate)
+        double meanBudgetPercent = 0.0, maxBudgetPercent = 0.0;
+    };
+
+    static constexpr int bucketsPerOctave = 4;
+    static constexpr int numBuckets = 24 * bucketsPerOctave;
+
+    void prepare (double sampleRate) noexcept
+    {
+        nsPerSample.store (1.0e9 / sampleRate, std::memory_order_relaxed);
+        reset();
+    }
+
+    // Clears the stats before the next recorded block
+    void reset() noexcept { resetPending.store (true, std::memory_order_release); }
+
+    // Audio thread
+    void record (juce::int64 ticks, int numSamples) noexcept
+    {
+        if (resetPending.exchange (false, std::memory_order_acquire))
+            clear();
+
+        const auto ns = (double) ticks * nsPerTick;
+        const auto budgetNs = numSamples * nsPerSample.load (std::memory_order_relaxed);
+        const auto count = numBlocks.load (std::memory_order_relaxed);
+
+        sumNs.store (sumNs.load (std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+        sumBudgetNs.store (sumBudgetNs.load (std::memory_order_relaxed) + budgetNs, std::memory_order_relaxed);
+
+        if (count == 0 || ns < minNs.load (std::memory_order_relaxed))
+            minNs.store (ns, std::memory_order_relaxed);
+        if (ns > maxNs.load (std::memory_order_relaxed))
+            maxNs.store (ns, std::memory_order_relaxed);
+        if (budgetNs > 0.0 && ns * 100.0 / budgetNs > maxBudgetPercent.load (std::memory_order_relaxed))
+            maxBudgetPercent.store (ns * 100.0 / budgetNs, std::memory_order_relaxed);
+
+        auto& bucket = buckets[(size_t) getBucket (ns)];
+        bucket.store (bucket.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        numBlocks.store (count + 1, std::memory_order_release);
+    }
+
+    // Any thread
+    Stats getStats() const noexcept
+    {
+        Stats stats;
+        stats.numBlocks = numBlocks.load (std::memory_order_acquire);
+
+        if (stats.numBlocks == 0)
+            return stats;
+
+        const auto totalNs = sumNs.load (std::memory_order_relaxed);
+        const auto totalBudgetNs = sumBudgetNs.load (std::memory_order_relaxed);
+
+        stats.minNs = minNs.load (std::memory_order_relaxed);
+        stats.maxNs = maxNs.load (std::memory_order_relaxed);
+        stats.meanNs = totalNs / (double) stats.numBlocks;
+        stats.meanBudgetPercent = totalBudgetNs > 0.0 ? totalNs * 100.0 / totalBudgetNs : 0.0;
+        stats.maxBudgetPercent = maxBudgetPercent.load (std::memory_order_relaxed);
+
+        // p99 is the upper edge of the bucket holding the 99th percentile block
+        const auto target = (juce::uint32) std::ceil ((double) stats.numBlocks * 0.99);
+        juce::uint32 seen = 0;
+
+        for (int i = 0; i < numBuckets; ++i)
+        {
+            seen += buckets[(size_t) i].load (std::memory_order_relaxed);
+
+            if (seen >= target)
+            {
+                stats.p99Ns = juce::jmin (stats.maxNs, getBucketUpperEdge (i));
+                break;
+            }
+        }
+
+        return stats;
+    }
+
+    // Times the enclosing scope and records it on destruction
+    struct ScopedTimer
+    {
+        ScopedTimer (BlockProfiler& p, int n) noexcept : profiler (p), numSamples (n) {}
+        ~ScopedTimer() noexcept { profiler.record (juce::Time::getHighResolutionTicks() - start, numSamples); }
+
+        BlockProfiler& profiler;
+        const int numSamples;
+        const juce::int64 start = juce::Time::getHighResolutionTicks();
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedTimer)
+    };
+
+private:
+    // The exponent of the float duration gives the octave and its top 2 mantissa bits the quarter
+    // of it, so buckets are linear within an octave rather than log-spaced
+    static constexpr int bucketShift = 23 - 2;
+    static constexpr juce::uint32 firstBucketBits = std::bit_cast<juce::uint32> (64.0f) >> bucketShift;
+
+    static int getBucket (double ns) noexcept
+    {
+        const auto bits = std::bit_cast<juce::uint32> ((float) juce::jmax (ns, 64.0)) >> bucketShift;
+        return juce::jmin ((int) (bits - firstBucketBits), numBuckets - 1);
+    }
+
+    static double getBucketUpperEdge (int bucket) noexcept
+    {
+        const auto octave = bucket / bucketsPerOctave;
+        const auto quarter = bucket % bucketsPerOctave;
+        return std::ldexp (64.0 * (1.0 + (double) (quarter + 1) / bucketsPerOctave), octave);
+    }
+
+    void clear() noexcept
+    {
+        numBlocks.store (0, std::memory_order_relaxed);
+        sumNs.store (0.0, std::memory_order_relaxed);
+        sumBudgetNs.store (0.0, std::memory_order_relaxed);
+        minNs.store (0.0, std::memory_order_relaxed);
+        maxNs.store (0.0, std::memory_order_relaxed);
+        maxBudgetPercent.store (0.0, std::memory_order_relaxed);
+
+        for (auto& bucket : buckets)
+            bucket.store (0, std::memory_order_relaxed);
+    }
+
+    const double nsPerTick = 1.0e9 / (double) juce::Time::getHighResolutionTicksPerSecond();
+    std::atomic<double> nsPerSample { 1.0e9 / 44100.0 };
+    std::atomic<bool> resetPending { false };
+
+    std::atomic<juce::int64> numBlocks { 0 };
+    std::atomic<double> sumNs { 0.0 }, sumBudgetNs { 0.0 }, minNs { 0.0 }, maxNs { 0.0 }, maxBudgetPercent { 0.0 };
+    std::array<std::atomic<juce::uint32>, numBuckets> buckets {};
+};
+
+#if LIFTER_PROFILING
+    #define LIFTER_PROFILE_BLOCK(profiler, numSamples) const BlockProfiler::ScopedTimer JUCE_JOIN_MACRO (blockTimer, __LINE__) (profiler, numSamples)
+#else
+    #define LIFTER_PROFILE_BLOCK(profiler, numSamples)
+#endif
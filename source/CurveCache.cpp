@@ -0,0 +1,80 @@
+#include "CurveCache.h"
+
+CurveCache::Ptr CurveCache::acquire (const GainCurve::Settings& settings, GainCurve::Resolution resolution)
+{
+    jassert (resolution != GainCurve::Resolution::exact);
+
+    const juce::ScopedLock sl (lock);
+
+    for (auto* entry : entries)
+    {
+        if (entry->table.getSettings() == settings && entry->table.getResolution() == resolution)
+        {
+            entry->lastUsed = ++useCounter;
+            ++hits;
+            return Ptr (entry);
+        }
+    }
+
+    // Sized for this resolution only, since a cached table is never rebuilt
+    Ptr entry = new Entry();
+    entry->table.allocate (resolution);
+    entry->table.build (settings, resolution);
+    entry->lastUsed = ++useCounter;
+    entries.add (entry);
+    ++builds;
+
+    evictUnused (maxUnusedTables);
+    return entry;
+}
+
+void CurveCache::purge()
+{
+    const juce::ScopedLock sl (lock);
+    evictUnused (0);
+}
+
+// An entry whose only reference is the array's cannot be picked up again without the lock,
+// so it is safe to free here
+void CurveCache::evictUnused (int numToKeep)
+{
+    for (;;)
+    {
+        int oldest = -1, numUnused = 0;
+
+        for (int i = 0; i < entries.size(); ++i)
+        {
+            if (entries.getObjectPointerUnchecked (i)->getReferenceCount() == 1)
+            {
+                ++numUnused;
+
+                if (oldest < 0 || entries.getObjectPointerUnchecked (i)->lastUsed < entries.getObjectPointerUnchecked (oldest)->lastUsed)
+                    oldest = i;
+            }
+        }
+
+        if (numUnused <= numToKeep)
+            return;
+
+        entries.remove (oldest);
+    }
+}
+
+CurveCache::Stats CurveCache::getStats() const
+{
+    const juce::ScopedLock sl (lock);
+    Stats stats;
+
+    for (auto* entry : entries)
+    {
+        ++stats.numTables;
+        stats.bytes += entry->table.getSizeInBytes();
+
+        if (entry->getReferenceCount() == 1)
+            ++stats.numUnused;
+    }
+
+    stats.hits = hits;
+    stats.builds = builds;
+    return stats;
+}
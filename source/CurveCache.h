@@ -0,0 +1,56 @@
+#pragma once
+
+#include "GainCurve.h"
+
+// Process-wide store of built curve tables, shared by every LifterEngine in every plugin instance.
+// Share it with juce::SharedResourcePointer<CurveCache>.
+//
+// A table depends only on the curve settings and the resolution, not on the sample rate,
+// so instances running the same preset read one table instead of each building its own.
+// Applying a preset to many tracks then builds the table once and the other instances hit it.
+//
+// Tables are never changed once built, and are reference counted. acquire() locks and may build,
+// so it is only called from the background thread or while preparing; the audio thread reads
+// the table through the pointer its engine already holds and never touches the counts.
+// Tables no engine holds any more are kept for a while, so switching back and forth between
+// presets stays cheap, and the oldest are freed by acquire() beyond maxUnusedTables.
+class CurveCache
+{
+public:
+    struct Entry : public juce::ReferenceCountedObject
+    {
+        GainCurve::Table table;
+        juce::uint64 lastUsed = 0;
+    };
+
+    using Ptr = juce::ReferenceCountedObjectPtr<Entry>;
+
+    // Tables nobody holds that are kept for later hits, about 450 KB at the finest resolution
+    static constexpr int maxUnusedTables = 32;
+
+    CurveCache() = default;
+
+    // Returns the table for these settings, building it if no instance has it yet
+    Ptr acquire (const GainCurve::Settings& settings, GainCurve::Resolution resolution);
+
+    // Frees every table no engine holds
+    void purge();
+
+    struct Stats
+    {
+        int numTables = 0, numUnused = 0;
+        size_t bytes = 0;
+        juce::uint64 hits = 0, builds = 0;
+    };
+
+    Stats getStats() const;
+
+private:
+    void evictUnused (int numToKeep);
+
+    juce::CriticalSection lock;
+    juce::ReferenceCountedArray<Entry> entries;
+    juce::uint64 useCounter = 0, hits = 0, builds = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CurveCache)
+};
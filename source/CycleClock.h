@@ -0,0 +1,39 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#if JUCE_INTEL && JUCE_MSVC
+    #include <intrin.h>
+#elif JUCE_INTEL
+    #include <x86intrin.h>
+#endif
+
+// Cheapest monotonic tick counter available on this CPU.
+// On x86 this is the TSC, which counts reference cycles at the nominal clock rate.
+// On 64-bit ARM it is the virtual counter, and elsewhere the JUCE high resolution ticks.
+struct CycleClock
+{
+    static juce::uint64 now() noexcept
+    {
+       #if JUCE_INTEL
+        return (juce::uint64) __rdtsc();
+       #elif JUCE_ARM && JUCE_64BIT && (JUCE_GCC || JUCE_CLANG)
+        juce::uint64 ticks;
+        asm volatile ("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+       #else
+        return (juce::uint64) juce::Time::getHighResolutionTicks();
+       #endif
+    }
+
+    static const char* getName() noexcept
+    {
+       #if JUCE_INTEL
+        return "tsc";
+       #elif JUCE_ARM && JUCE_64BIT && (JUCE_GCC || JUCE_CLANG)
+        return "cntvct";
+       #else
+        return "hires-ticks";
+       #endif
+    }
+};
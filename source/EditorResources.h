@@ -0,0 +1,16 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "punk_dsp/punk_dsp.h"
+
+// Look-and-feel and fonts shared by every editor in the process, through a
+// juce::SharedResourcePointer: created with the first editor, released with the last.
+// Glyphs drawn with the same Font objects also stay warm in JUCE's glyph cache between editors.
+struct EditorResources
+{
+    punk_dsp::ExamplesLnF lookAndFeel;
+    
+    const juce::Font meterFont { juce::FontOptions { 16.0f } };
+    const juce::Font monospacedFont { juce::FontOptions { juce::Font::getDefaultMonospacedFontName(), 12.0f, juce::Font::plain } };
+    const juce::Font labelFont { juce::FontOptions { 11.0f } };
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <bit>
+
+// Static transfer curve of the Lifter: the gain it adds for a given input level.
+// It is a pure function of threshold, ratio, knee and makeup, so it can be tabulated.
+namespace GainCurve
+{
+    // Levels below this are treated as this level, so silence gets a finite lift
+    constexpr auto levelFloorDb = -90.0f;
+
+    struct Settings
+    {
+        float thres = -40.0f;   // dB
+        float ratio = 4.0f;     // :1
+        float knee = 12.0f;     // dB
+        float makeup = 0.0f;    // dB
+
+        bool operator== (const Settings&) const = default;
+    };
+
+    // Upward compression with a quadratic soft knee, in dB
+    inline float computeGainAdditionDb (float levelDb, const Settings& s) noexcept
+    {
+        const auto slope = 1.0f - 1.0f / s.ratio;
+        const auto overshoot = juce::jmax (levelDb, levelFloorDb) - s.thres;
+
+        if (2.0f * overshoot < -s.knee)
+            return -slope * overshoot;
+
+        if (2.0f * overshoot > s.knee)
+            return 0.0f;
+
+        const auto x = overshoot - 0.5f * s.knee;
+        return slope * x * x / (2.0f * s.knee);
+    }
+
+    // Exact path: linear input magnitude in, linear gain (including makeup) out
+    inline float computeGain (float level, const Settings& s) noexcept
+    {
+        const auto levelDb = juce::Decibels::gainToDecibels (level, levelFloorDb);
+        return juce::Decibels::decibelsToGain (computeGainAdditionDb (levelDb, s) + s.makeup, -1000.0f);
+    }
+
+    //==============================================================================
+    // Table resolution, in nodes per octave of input level
+    enum class Resolution
+    {
+        exact,  // No table, dB conversions on every sample
+        coarse, //   8 nodes/octave,  225 entries (0.9 KB), max error vs computeGain() 0.20 dB
+        medium, //  32 nodes/octave,  897 entries (3.5 KB), max error vs computeGain() 0.035 dB
+        fine    // 128 nodes/octave, 3585 entries (14 KB),  max error vs computeGain() 0.015 dB
+    };
+
+    constexpr int getBitsPerOctave (Resolution r) noexcept
+    {
+        return r == Resolution::coarse ? 3 : r == Resolution::medium ? 5 : 7;
+    }
+
+    // Interpolated curve table indexed straight from the bits of the input magnitude.
+    // The float exponent picks the octave and the top mantissa bits the node inside it,
+    // so a lookup needs no log or exp. Nodes span 2^-24 to 2^4 (-144 dB to +24 dB);
+    // levels outside are clamped to the end nodes.
+    //
+    // The max errors listed in Resolution are the largest difference, in dB, against
+    // computeGain() over that level span with ratio 1-100, knee 1-30 dB and any threshold.
+    // The worst case sits at the levelFloorDb corner, where the curve has a kink.
+    // See `LifterBenchmark --mode=curve` to measure them again. computeGain() is this file's
+    // model of the curve, not punk_dsp::Lifter: `LifterNullTest` measures the exact engine and
+    // every table against punk_dsp::Lifter's settled output, which is what the plugin's default
+    // path sounds like.
+    constexpr juce::uint32 tableMinBits = (127u - 24u) << 23;
+    constexpr juce::uint32 tableMaxBits = (127u + 4u) << 23;
+
+    // Read-only view of a built table, cheap to copy into the processing kernels
+    struct TableView
+    {
+        const float* values = nullptr;
+        juce::uint32 shift = 23, fractionMask = 0, lastIndex = 0;
+        float fractionScale = 1.0f;
+
+        // level must be a magnitude (>= 0)
+        float lookup (float level) const noexcept
+        {
+            const auto bits = std::bit_cast<juce::uint32> (level);
+
+            if (bits <= tableMinBits)
+                return values[0];
+            if (bits >= tableMaxBits)
+                return values[lastIndex];
+
+            const auto offset = bits - tableMinBits;
+            const auto index = offset >> shift;
+            const auto fraction = (float) (offset & fractionMask) * fractionScale;
+
+            return values[index] + fraction * (values[index + 1] - values[index]);
+        }
+    };
+
+    class Table
+    {
+    public:
+        Table() = default;
+
+        static constexpr int getNumEntries (int bitsPerOctave) noexcept
+        {
+            return (int) ((tableMaxBits - tableMinBits) >> (23 - bitsPerOctave)) + 1;
+        }
+
+        // Reserves room for tables up to maxResolution, so rebuilds at or below it never allocate.
+        // One extra entry past the end lets vector kernels interpolate at the top node unchecked.
+        void allocate (Resolution maxResolution = Resolution::fine)
+        {
+            values.resize ((size_t) getNumEntries (getBitsPerOctave (maxResolution)) + 1);
+            view.values = values.data();
+        }
+
+        void build (const Settings& newSettings, Resolution newResolution) noexcept
+        {
+            jassert (newResolution != Resolution::exact);
+            jassert (values.size() > (size_t) getNumEntries (getBitsPerOctave (newResolution)));
+
+            settings = newSettings;
+            resolution = newResolution;
+
+            const auto shift = (juce::uint32) (23 - getBitsPerOctave (resolution));
+            view.shift = shift;
+            view.fractionMask = (1u << shift) - 1u;
+            view.fractionScale = 1.0f / (float) (1u << shift);
+            view.lastIndex = (juce::uint32) getNumEntries (getBitsPerOctave (resolution)) - 1;
+
+            for (juce::uint32 i = 0; i <= view.lastIndex; ++i)
+                values[i] = computeGain (std::bit_cast<float> (tableMinBits + (i << shift)), settings);
+
+            values[view.lastIndex + 1] = values[view.lastIndex];
+        }
+
+        float lookup (float level) const noexcept { return view.lookup (level); }
+
+        const TableView& getView() const noexcept { return view; }
+        const Settings& getSettings() const noexcept { return settings; }
+        Resolution getResolution() const noexcept { return resolution; }
+        size_t getSizeInBytes() const noexcept { return values.size() * sizeof (float); }
+
+    private:
+        std::vector<float> values;
+        TableView view;
+        Settings settings;
+        Resolution resolution = Resolution::exact;
+
+        JUCE_DECLARE_NON_COPYABLE (Table)
+    };
+
+    // Largest difference between the table and the exact curve, in dB, over the table span
+    inline float measureMaxErrorDb (const Table& table, int numPoints = 100000)
+    {
+        auto maxError = 0.0f;
+
+        for (int i = 0; i < numPoints; ++i)
+        {
+            const auto levelDb = juce::jmap ((float) i, 0.0f, (float) (numPoints - 1), -144.0f, 24.0f);
+            const auto level = juce::Decibels::decibelsToGain (levelDb, -1000.0f);
+            const auto error = juce::Decibels::gainToDecibels (table.lookup (level), -1000.0f)
+                             - juce::Decibels::gainToDecibels (computeGain (level, table.getSettings()), -1000.0f);
+
+            maxError = juce::jmax (maxError, std::abs (error));
+        }
+
+        return maxError;
+    }
+}
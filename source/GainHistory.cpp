@@ -0,0 +1,57 @@
+#include "GainHistory.h"
+#include "punk_dsp/punk_dsp.h"
+
+GainHistory::GainHistory()
+{
+    setOpaque (true);
+}
+
+void GainHistory::pushFrame (const MeterFrame& frame)
+{
+    columns[(size_t) writeIndex] = frame;
+    writeIndex = (writeIndex + 1) % numColumns;
+}
+
+void GainHistory::paint (juce::Graphics& g)
+{
+    g.fillAll (punk_dsp::UIConstants::background.brighter (0.5f).withAlpha (0.25f));
+
+    const auto bounds = getLocalBounds().toFloat();
+    const auto columnWidth = bounds.getWidth() / (float) numColumns;
+
+    auto levelToY = [&bounds] (float linear)
+    {
+        const auto db = juce::Decibels::gainToDecibels (linear, minLevelDb);
+        return juce::jmap (db, minLevelDb, 0.0f, bounds.getBottom(), bounds.getY());
+    };
+
+    juce::Path inputPath, outputPath;
+
+    // Oldest column on the left, newest on the right
+    for (int i = 0; i < numColumns; ++i)
+    {
+        const auto& frame = columns[(size_t) ((writeIndex + i) % numColumns)];
+        const auto x = bounds.getX() + (float) i * columnWidth;
+
+        // Gain addition hangs from the top edge
+        const auto gaHeight = juce::jlimit (0.0f, 1.0f, std::abs (frame.gainAddition) / maxGainDb) * bounds.getHeight();
+        g.setColour (juce::Colours::orange.withAlpha (0.6f));
+        g.fillRect (x, bounds.getY(), columnWidth, gaHeight);
+
+        if (i == 0)
+        {
+            inputPath.startNewSubPath (x, levelToY (frame.inputPeak));
+            outputPath.startNewSubPath (x, levelToY (frame.outputPeak));
+        }
+        else
+        {
+            inputPath.lineTo (x, levelToY (frame.inputPeak));
+            outputPath.lineTo (x, levelToY (frame.outputPeak));
+        }
+    }
+
+    g.setColour (juce::Colours::white.withAlpha (0.4f));
+    g.strokePath (inputPath, juce::PathStrokeType (1.0f));
+    g.setColour (juce::Colours::white);
+    g.strokePath (outputPath, juce::PathStrokeType (1.5f));
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "MeterFifo.h"
+
+//==============================================================================
+// Scrolling view of the gain addition, input peak and output peak frames
+class GainHistory : public juce::Component
+{
+public:
+    static constexpr int numColumns = 256;      // 2.56 s at MeterFifo::framesPerSecond
+    static constexpr float maxGainDb = 24.0f;
+    static constexpr float minLevelDb = -60.0f;
+
+    GainHistory();
+
+    void pushFrame (const MeterFrame& frame);
+
+    void paint (juce::Graphics&) override;
+
+private:
+    std::array<MeterFrame, numColumns> columns {};
+    int writeIndex = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GainHistory)
+};
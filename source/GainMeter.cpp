@@ -0,0 +1,38 @@
+#include "GainMeter.h"
+#include "punk_dsp/punk_dsp.h"
+
+GainMeter::GainMeter()
+{
+    setOpaque (true);
+}
+
+bool GainMeter::setGainAddition (float gainAdditionDb)
+{
+    const auto newSteps = juce::roundToInt (gainAdditionDb / stepDb);
+
+    if (newSteps == steps)
+        return false;
+
+    steps = newSteps;
+    repaint();
+    return true;
+}
+
+void GainMeter::paint (juce::Graphics& g)
+{
+    const auto value = (float) steps * stepDb;
+    auto bounds = getLocalBounds().toFloat();
+
+    g.fillAll (punk_dsp::UIConstants::background);
+    g.setColour (punk_dsp::UIConstants::background.brighter (0.5f).withAlpha (0.25f));
+    g.fillRoundedRectangle (bounds, 4.0f);
+
+    // Bar along the bottom edge, same scale as the history view
+    const auto fraction = juce::jlimit (0.0f, 1.0f, std::abs (value) / maxGainDb);
+    g.setColour (juce::Colours::orange.withAlpha (0.6f));
+    g.fillRect (bounds.removeFromBottom (6.0f).reduced (6.0f, 0.0f).withWidth ((bounds.getWidth() - 12.0f) * fraction));
+
+    g.setColour (juce::Colours::white);
+    g.setFont (resources->meterFont);
+    g.drawText ("GA: " + juce::String (value, 1) + " dB", bounds, juce::Justification::centred, false);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "EditorResources.h"
+
+//==============================================================================
+// Gain addition readout. The value is quantized to what the display can show, and the
+// component only repaints when that visible value changes. It is opaque, so a repaint
+// never drags the editor background along with it.
+class GainMeter : public juce::Component
+{
+public:
+    static constexpr float stepDb = 0.1f;      // One digit after the point
+    static constexpr float maxGainDb = 24.0f;  // Full bar
+
+    GainMeter();
+
+    // Message thread, as often as wanted. Returns true if it caused a repaint.
+    bool setGainAddition (float gainAdditionDb);
+
+    void paint (juce::Graphics&) override;
+
+private:
+    juce::SharedResourcePointer<EditorResources> resources;
+    int steps = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GainMeter)
+};
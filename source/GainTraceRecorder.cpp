@@ -0,0 +1,244 @@
+#include "GainTraceRecorder.h"
+
+GainTraceRecorder::GainTraceRecorder()
+{
+    backgroundThread->addTimeSliceClient (this);
+}
+
+GainTraceRecorder::~GainTraceRecorder()
+{
+    stop();
+    backgroundThread->removeTimeSliceClient (this);
+}
+
+void GainTraceRecorder::prepare (int maximumBlockSize)
+{
+    inputLevels.resize ((size_t) maximumBlockSize);
+}
+
+//==============================================================================
+bool GainTraceRecorder::start (const juce::File& newFile, double sampleRate, int newSamplesPerRecord)
+{
+    stop();
+
+    const juce::ScopedLock sl (lock);
+    file = newFile;
+    file.deleteFile();
+
+    {
+        juce::FileOutputStream out (file);
+
+        if (! out.openedOk())
+            return false;
+
+        out.writeInt ((int) magic);
+        out.writeInt ((int) version);
+        out.writeInt (headerSize);
+        out.writeInt ((int) sizeof (Record));
+        out.writeDouble (sampleRate);
+        out.writeInt (juce::jmax (1, newSamplesPerRecord));
+        out.writeInt (0);
+        out.writeInt64 (0);
+        out.writeInt64 (0);
+        out.writeRepeatedByte (0, 16);
+    }
+
+    header = std::make_unique<juce::MemoryMappedFile> (file, juce::Range<juce::int64> (0, headerSize), juce::MemoryMappedFile::readWrite, false);
+
+    if (header->getData() == nullptr)
+    {
+        header.reset();
+        return false;
+    }
+
+    nextSegmentIndex = 0;
+    auto first = mapSegment (nextSegmentIndex++);
+
+    if (first == nullptr)
+    {
+        header.reset();
+        return false;
+    }
+
+    // Nothing is writing yet, so the audio thread state can be set from here
+    current = first.release();
+    writePosition = current->data;
+    samplesPerRecord = juce::jmax (1, newSamplesPerRecord);
+    pending = { 0.0f, 0.0f, 0.0f };
+    pendingSamples = 0;
+    recordsWritten.store (0);
+    recordsDropped.store (0);
+
+    if (auto second = mapSegment (nextSegmentIndex))
+    {
+        ++nextSegmentIndex;
+        next.store (second.release());
+    }
+
+    recording.store (true);
+
+    // The thread idles slowly while nothing is recording, so get the next segment mapped now
+    backgroundThread->moveToFrontOfQueue (this);
+    return true;
+}
+
+void GainTraceRecorder::stop()
+{
+    if (! recording.exchange (false))
+        return;
+
+    // A block that saw recording still on may be writing, it finishes without waiting on anything
+    while (activeWriters.load() != 0)
+        juce::Thread::yield();
+
+    const juce::ScopedLock sl (lock);
+    retireSegments();
+
+    delete current;
+    delete next.exchange (nullptr);
+    current = nullptr;
+    writePosition = nullptr;
+
+    updateHeader();
+    header.reset();
+
+    // Cut the space mapped ahead, so the file ends at the last record
+    juce::FileOutputStream out (file);
+
+    if (out.openedOk())
+    {
+        out.setPosition (headerSize + recordsWritten.load() * (juce::int64) sizeof (Record));
+        out.truncate();
+    }
+}
+
+//==============================================================================
+int GainTraceRecorder::useTimeSlice()
+{
+    // stop() retires everything itself, so there is nothing to do until the next start()
+    if (! recording.load())
+        return 500;
+
+    const juce::ScopedLock sl (lock);
+    retireSegments();
+
+    if (recording.load())
+    {
+        if (next.load() == nullptr)
+        {
+            if (auto segment = mapSegment (nextSegmentIndex))
+            {
+                ++nextSegmentIndex;
+                next.store (segment.release());
+            }
+        }
+
+        updateHeader();
+    }
+
+    return 20;
+}
+
+std::unique_ptr<GainTraceRecorder::Segment> GainTraceRecorder::mapSegment (juce::int64 index)
+{
+    const auto bytes = segmentRecords * (juce::int64) sizeof (Record);
+    const auto offset = headerSize + index * bytes;
+
+    // Grow the file over the segment first. The new space is sparse until it is written.
+    {
+        juce::FileOutputStream out (file);
+
+        if (! out.openedOk() || ! out.setPosition (offset + bytes) || out.truncate().failed())
+            return {};
+    }
+
+    auto segment = std::make_unique<Segment>();
+    segment->map = std::make_unique<juce::MemoryMappedFile> (file, juce::Range<juce::int64> (offset, offset + bytes), juce::MemoryMappedFile::readWrite, false);
+
+    auto* mapped = static_cast<char*> (segment->map->getData());
+
+    if (mapped == nullptr)
+        return {};
+
+    // The mapping starts on a page boundary, which can be before the segment
+    const auto range = segment->map->getRange();
+    segment->data = mapped + (offset - range.getStart());
+    segment->end = mapped + range.getLength();
+    return segment;
+}
+
+// Unmapping a full segment hands its pages to the OS to write back
+void GainTraceRecorder::retireSegments()
+{
+    for (auto* segment = retiredHead.exchange (nullptr, std::memory_order_acquire); segment != nullptr;)
+        delete std::exchange (segment, segment->nextRetired);
+}
+
+void GainTraceRecorder::updateHeader()
+{
+    if (header == nullptr)
+        return;
+
+    const auto written = juce::ByteOrder::swapIfBigEndian ((juce::uint64) recordsWritten.load());
+    const auto dropped = juce::ByteOrder::swapIfBigEndian ((juce::uint64) recordsDropped.load());
+
+    auto* data = static_cast<char*> (header->getData());
+    std::memcpy (data + 32, &written, sizeof (written));
+    std::memcpy (data + 40, &dropped, sizeof (dropped));
+}
+
+//==============================================================================
+void GainTraceRecorder::write (const Record& record) noexcept
+{
+    if (writePosition == nullptr || writePosition + sizeof (Record) > current->end)
+    {
+        if (! advanceSegment())
+        {
+            recordsDropped.fetch_add (1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    std::memcpy (writePosition, &record, sizeof (Record));
+    writePosition += sizeof (Record);
+    recordsWritten.fetch_add (1, std::memory_order_relaxed);
+}
+
+bool GainTraceRecorder::advanceSegment() noexcept
+{
+    auto* segment = next.exchange (nullptr);
+
+    // Offline nothing waits on this thread, so map the segment here rather than drop records
+    if (segment == nullptr && nonRealtime.load())
+    {
+        const juce::ScopedLock sl (lock);
+
+        if ((segment = next.exchange (nullptr)) == nullptr)
+        {
+            if (auto mapped = mapSegment (nextSegmentIndex))
+            {
+                ++nextSegmentIndex;
+                segment = mapped.release();
+            }
+        }
+    }
+
+    if (segment == nullptr)
+        return false;
+
+    // The full one goes back to the background thread to be unmapped
+    if (current != nullptr)
+        retire (current);
+
+    current = segment;
+    writePosition = segment->data;
+    return true;
+}
+
+void GainTraceRecorder::retire (Segment* segment) noexcept
+{
+    segment->nextRetired = retiredHead.load (std::memory_order_relaxed);
+
+    while (! retiredHead.compare_exchange_weak (segment->nextRetired, segment, std::memory_order_release, std::memory_order_relaxed))
+        ;
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "BackgroundThread.h"
+
+// Records the gain the Lifter applied, with the input and output levels around it, to a
+// memory-mapped file for offline analysis (loudness QA, comparing renders).
+//
+// The audio thread only stores records into a mapped segment of the file. The background
+// thread grows the file and maps the next segment ahead of it, and unmaps full ones so the
+// OS writes them back, so a render of any length keeps at most three segments in memory.
+// In realtime, if the next segment is not ready in time the records are dropped and counted,
+// never waited for. Offline (setNonRealtime) the audio thread maps it itself, so nothing is dropped.
+//
+// File format, little-endian:
+//
+//   Offset  Size  Field
+//   0       4     Magic "LftT"
+//   4       4     Version, 1
+//   8       4     Header size in bytes, 64
+//   12      4     Record size in bytes, 12
+//   16      8     Sample rate (double)
+//   24      4     Samples per record
+//   28      4     Reserved
+//   32      8     Records written (uint64), kept up to date while recording
+//   40      8     Records dropped because the next segment was not mapped in time (uint64)
+//   48      16    Reserved
+//   64            Records, one per "samples per record" samples:
+//                   float gainAdditionDb  Detector gain addition at the end of the processor sub-block
+//                                         holding the record's last sample, makeup and mix excluded
+//                   float inputPeak       Largest input magnitude across channels and samples (linear)
+//                   float outputPeak      Largest output magnitude across channels and samples (linear)
+//
+// gainAdditionDb is one reading per sub-block (128 samples by default), not per sample.
+// outputPeak / inputPeak is the gain applied, dry/wet mix included, only with one sample per
+// record on a mono signal; with more channels the two peaks can come from different channels.
+// The file is truncated to the records written when recording stops.
+class GainTraceRecorder : private juce::TimeSliceClient
+{
+public:
+    static constexpr juce::uint32 magic = 0x5474664c; // "LftT"
+    static constexpr juce::uint32 version = 1;
+    static constexpr int headerSize = 64;
+
+    struct Record
+    {
+        float gainAdditionDb, inputPeak, outputPeak;
+    };
+
+    static_assert (sizeof (Record) == 12);
+
+    // Records per mapped segment, 48 MB
+    static constexpr juce::int64 segmentRecords = 1 << 22;
+
+    GainTraceRecorder();
+    ~GainTraceRecorder() override;
+
+    // Sizes the input level scratch, call from prepareToPlay
+    void prepare (int maximumBlockSize);
+
+    // Message thread or any non-audio thread. Returns false if the file cannot be created or mapped.
+    bool start (const juce::File& file, double sampleRate, int samplesPerRecord);
+    void stop();
+
+    // Offline the audio thread maps segments itself when the background thread falls behind
+    void setNonRealtime (bool isNonRealtime) noexcept { nonRealtime.store (isNonRealtime); }
+
+    bool isRecording() const noexcept { return recording.load(); }
+    juce::int64 getNumRecordsWritten() const noexcept { return recordsWritten.load (std::memory_order_relaxed); }
+    juce::int64 getNumRecordsDropped() const noexcept { return recordsDropped.load (std::memory_order_relaxed); }
+
+    //==============================================================================
+    // Audio thread access for one block. stop() waits until no writer is active,
+    // and the writer never waits for anything.
+    class ScopedWriter
+    {
+    public:
+        explicit ScopedWriter (GainTraceRecorder& r) noexcept : recorder (r)
+        {
+            recorder.activeWriters.fetch_add (1);
+            active = recorder.recording.load();
+        }
+
+        ~ScopedWriter() noexcept { recorder.activeWriters.fetch_sub (1); }
+
+        bool isActive() const noexcept { return active; }
+
+        // Per-sample input levels, read before any processing in case it runs in place
+        template <typename SampleType>
+        void captureInput (const juce::dsp::AudioBlock<const SampleType>& input) noexcept;
+
+        // Pairs the output with the captured input and writes the finished records
+        template <typename SampleType>
+        void recordOutput (const juce::AudioBuffer<SampleType>& buffer, float gainAdditionDb) noexcept;
+
+    private:
+        GainTraceRecorder& recorder;
+        bool active = false;
+    };
+
+private:
+    struct Segment
+    {
+        std::unique_ptr<juce::MemoryMappedFile> map;
+        char* data = nullptr;
+        char* end = nullptr;
+        Segment* nextRetired = nullptr;
+    };
+
+    int useTimeSlice() override;
+    std::unique_ptr<Segment> mapSegment (juce::int64 index);
+    void retireSegments();
+    void updateHeader();
+
+    // Audio thread
+    void write (const Record& record) noexcept;
+    bool advanceSegment() noexcept;
+    void retire (Segment* segment) noexcept;
+
+    juce::SharedResourcePointer<BackgroundThread> backgroundThread;
+
+    std::atomic<bool> recording { false }, nonRealtime { false };
+    std::atomic<int> activeWriters { 0 };
+    std::atomic<juce::int64> recordsWritten { 0 }, recordsDropped { 0 };
+
+    // Segments pass from the background thread to the audio thread through next, and back
+    // through the retired list once full. The list is a lock-free stack with one pusher (the
+    // audio thread), emptied in one exchange, so it has no capacity to run out of.
+    std::atomic<Segment*> next { nullptr };
+    std::atomic<Segment*> retiredHead { nullptr };
+
+    // Background side, under lock
+    juce::CriticalSection lock;
+    juce::File file;
+    std::unique_ptr<juce::MemoryMappedFile> header;
+    juce::int64 nextSegmentIndex = 0;
+
+    // Audio thread state
+    Segment* current = nullptr;
+    char* writePosition = nullptr;
+    int samplesPerRecord = 1;
+    std::vector<float> inputLevels;
+    Record pending { 0.0f, 0.0f, 0.0f };
+    int pendingSamples = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GainTraceRecorder)
+};
+
+//==============================================================================
+template <typename SampleType>
+void GainTraceRecorder::ScopedWriter::captureInput (const juce::dsp::AudioBlock<const SampleType>& input) noexcept
+{
+    const auto numSamples = juce::jmin ((int) input.getNumSamples(), (int) recorder.inputLevels.size());
+    auto* levels = recorder.inputLevels.data();
+
+    std::fill (levels, levels + numSamples, 0.0f);
+
+    for (size_t ch = 0; ch < input.getNumChannels(); ++ch)
+    {
+        const auto* data = input.getChannelPointer (ch);
+
+        for (int i = 0; i < numSamples; ++i)
+            levels[i] = juce::jmax (levels[i], (float) std::abs (data[i]));
+    }
+}
+
+template <typename SampleType>
+void GainTraceRecorder::ScopedWriter::recordOutput (const juce::AudioBuffer<SampleType>& buffer, float gainAdditionDb) noexcept
+{
+    const auto numSamples = juce::jmin (buffer.getNumSamples(), (int) recorder.inputLevels.size());
+    const auto* levels = recorder.inputLevels.data();
+    auto& pending = recorder.pending;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto outputLevel = 0.0f;
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            outputLevel = juce::jmax (outputLevel, (float) std::abs (buffer.getSample (ch, i)));
+
+        pending.inputPeak = juce::jmax (pending.inputPeak, levels[i]);
+        pending.outputPeak = juce::jmax (pending.outputPeak, outputLevel);
+
+        if (++recorder.pendingSamples == recorder.samplesPerRecord)
+        {
+            pending.gainAdditionDb = gainAdditionDb;
+            recorder.write (pending);
+            pending = { 0.0f, 0.0f, 0.0f };
+            recorder.pendingSamples = 0;
+        }
+    }
+}
@@ -0,0 +1,588 @@
+#include "LifterEngine.h"
+
+namespace
+{
+    double computeCoefficient (float timeMs, double sampleRate)
+    {
+        return std::exp (-1.0 / (timeMs * 0.001 * sampleRate));
+    }
+}
+
+LifterEngine::LifterEngine()
+{
+    backgroundThread->addTimeSliceClient (this);
+}
+
+LifterEngine::~LifterEngine()
+{
+    backgroundThread->removeTimeSliceClient (this);
+}
+
+void LifterEngine::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+    gain.resize (spec.numChannels);
+    rampStep.resize (spec.numChannels);
+    pendingPeak.resize (spec.numChannels);
+    sidechain.resize (spec.numChannels);
+    floatScratch.allocate (scratchSize);
+    doubleScratch.allocate (scratchSize);
+    floatTruePeak.prepare ((int) spec.numChannels, scratchSize);
+    doubleTruePeak.prepare ((int) spec.numChannels, scratchSize);
+
+    updateAttack (attackMs);
+    updateRelease (releaseMs);
+
+    // Make sure there is a table for the current settings before the first block
+    {
+        const juce::ScopedLock sl (builderLock);
+
+        if (resolution.load() != GainCurve::Resolution::exact)
+            rebuildTable (curveVersion.load());
+    }
+
+    tables.update();
+    reset();
+}
+
+void LifterEngine::reset()
+{
+    std::fill (gain.begin(), gain.end(), (double) makeupGain);
+    std::fill (sidechain.begin(), sidechain.end(), 0.0);
+    linkedGain = makeupGain;
+    linkedSidechain = 0.0;
+    std::fill (rampStep.begin(), rampStep.end(), 0.0);
+    std::fill (pendingPeak.begin(), pendingPeak.end(), 0.0);
+    linkedRampStep = 0.0;
+    controlPhase = 0;
+    gainAddition = 0.0f;
+    floatTruePeak.reset();
+    doubleTruePeak.reset();
+}
+
+//==============================================================================
+void LifterEngine::updateRatio (float newRatio)
+{
+    curve.ratio = newRatio;
+    sharedRatio.store (newRatio, std::memory_order_relaxed);
+    curveChanged();
+}
+
+void LifterEngine::updateRange (float newThres)
+{
+    curve.thres = newThres;
+    sharedThres.store (newThres, std::memory_order_relaxed);
+    curveChanged();
+}
+
+void LifterEngine::updateKnee (float newKnee)
+{
+    curve.knee = newKnee;
+    sharedKnee.store (newKnee, std::memory_order_relaxed);
+    curveChanged();
+}
+
+void LifterEngine::updateAttack (float newAttackMs)
+{
+    attackMs = newAttackMs;
+    attackCoeff = computeCoefficient (attackMs, sampleRate);
+    updateControlCoefficients();
+}
+
+void LifterEngine::updateRelease (float newReleaseMs)
+{
+    releaseMs = newReleaseMs;
+    releaseCoeff = computeCoefficient (releaseMs, sampleRate);
+    updateControlCoefficients();
+}
+
+void LifterEngine::updateMakeUp (float newMakeupDb)
+{
+    rampMakeUp (newMakeupDb);
+    sharedMakeup.store (newMakeupDb, std::memory_order_relaxed);
+    curveChanged();
+}
+
+void LifterEngine::rampMakeUp (float makeupDb) noexcept
+{
+    curve.makeup = makeupDb;
+    makeupGain = juce::Decibels::decibelsToGain (makeupDb);
+    inverseMakeupGain = 1.0f / makeupGain;
+}
+
+void LifterEngine::updateFeedForward (bool shouldFeedForward)
+{
+    feedForward = shouldFeedForward;
+}
+
+void LifterEngine::updateMix (float newMixPercent)
+{
+    mix = newMixPercent * 0.01f;
+}
+
+void LifterEngine::setCurveResolution (GainCurve::Resolution newResolution)
+{
+    if (resolution.exchange (newResolution) != newResolution)
+        curveChanged();
+}
+
+void LifterEngine::setControlInterval (int newInterval)
+{
+    // A control period has to fit in the ramp scratch
+    controlInterval = juce::jlimit (1, scratchSize, newInterval);
+    controlPhase = 0;
+    updateControlCoefficients();
+}
+
+void LifterEngine::setTruePeakFactor (int newFactor)
+{
+    floatTruePeak.setFactor (newFactor);
+    doubleTruePeak.setFactor (newFactor);
+}
+
+void LifterEngine::updateControlCoefficients() noexcept
+{
+    controlAttackCoeff = std::pow (attackCoeff, (double) controlInterval);
+    controlReleaseCoeff = std::pow (releaseCoeff, (double) controlInterval);
+}
+
+//==============================================================================
+int LifterEngine::useTimeSlice()
+{
+    const auto version = curveVersion.load (std::memory_order_acquire);
+
+    if (version != builtVersion.load (std::memory_order_acquire) && resolution.load() != GainCurve::Resolution::exact)
+    {
+        const juce::ScopedLock sl (builderLock);
+
+        // prepare() may have built it while this thread waited for the lock
+        if (version != builtVersion.load (std::memory_order_relaxed))
+            rebuildTable (version);
+    }
+
+    return 10;
+}
+
+void LifterEngine::rebuildTable (juce::uint32 version)
+{
+    // Reading the version before the settings means a newer change always triggers another rebuild
+    const GainCurve::Settings settings { sharedThres.load(), sharedRatio.load(), sharedKnee.load(), sharedMakeup.load() };
+
+    // Equal settings in any instance share one table, so this only builds on a cache miss
+    tables.getWriteBuffer() = curveCache->acquire (settings, resolution.load());
+    tables.publish();
+    builtVersion.store (version, std::memory_order_release);
+}
+
+//==============================================================================
+template <typename ProcessContext>
+void LifterEngine::process (const ProcessContext& context)
+{
+    const auto& input = context.getInputBlock();
+    const auto& output = context.getOutputBlock();
+    const auto numChannels = context.isBypassed ? 0 : juce::jmin ((int) output.getNumChannels(), (int) input.getNumChannels(), (int) gain.size());
+
+    // Channels left out pass through unchanged, as they do in place, and output channels
+    // with no input to match are cleared rather than left holding whatever was there
+    if constexpr (ProcessContext::usesSeparateInputAndOutputBlocks())
+    {
+        const auto first = (size_t) numChannels;
+        const auto numShared = juce::jmin (output.getNumChannels(), input.getNumChannels());
+        const auto count = numShared - first;
+
+        if (count > 0)
+            output.getSubsetChannelBlock (first, count).copyFrom (input.getSubsetChannelBlock (first, count));
+
+        if (output.getNumChannels() > numShared)
+            output.getSubsetChannelBlock (numShared, output.getNumChannels() - numShared).clear();
+    }
+
+    if (numChannels == 0 || output.getNumSamples() == 0)
+        return;
+
+    tables.update();
+    const auto* entry = tables.getReadBuffer().get();
+
+    // Until a table for this curve is ready, or while a ramp is on its way to it, stay on the exact curve
+    const auto useTable = resolution.load (std::memory_order_relaxed) != GainCurve::Resolution::exact
+                       && entry != nullptr
+                       && entry->table.getSettings() == curve;
+
+    const auto* activeTable = useTable ? &entry->table : nullptr;
+    auto lookup = [activeTable] (float level) { return activeTable->lookup (level); };
+    auto exact = [this] (float level) { return GainCurve::computeGain (level, curve); };
+
+    if (controlInterval > 1)
+    {
+        processControlRate (input, output, numChannels, activeTable);
+    }
+    else if (link == Link::perChannel)
+    {
+        if (feedForward)
+            processFeedForward (input, output, numChannels, activeTable);
+        else if (useTable)
+            processFeedBack (input, output, numChannels, lookup);
+        else
+            processFeedBack (input, output, numChannels, exact);
+    }
+    else
+    {
+        if (feedForward)
+            processLinkedFeedForward (input, output, numChannels, activeTable);
+        else if (useTable)
+            processLinkedFeedBack (input, output, numChannels, lookup);
+        else
+            processLinkedFeedBack (input, output, numChannels, exact);
+    }
+
+    if (link == Link::perChannel)
+    {
+        auto maxGain = 0.0;
+        for (int ch = 0; ch < numChannels; ++ch)
+            maxGain = juce::jmax (maxGain, gain[(size_t) ch]);
+
+        gainAddition = juce::Decibels::gainToDecibels ((float) maxGain * inverseMakeupGain);
+    }
+    else
+    {
+        gainAddition = juce::Decibels::gainToDecibels ((float) linkedGain * inverseMakeupGain);
+    }
+}
+
+template <typename SampleType>
+void LifterEngine::process (juce::AudioBuffer<SampleType>& buffer)
+{
+    juce::dsp::AudioBlock<SampleType> block (buffer);
+    process (juce::dsp::ProcessContextReplacing<SampleType> (block));
+}
+
+//==============================================================================
+// The curve and its tables are float, so double samples are looked up as floats.
+// That only rounds the gain target; the signal path and the envelope stay double.
+template <typename SampleType>
+void LifterEngine::computeGains (const GainCurve::Table* table, const SampleType* levels, SampleType* gains, int numSamples)
+{
+    if constexpr (std::is_same_v<SampleType, float>)
+    {
+        if (table != nullptr)
+            kernels->lookup (table->getView(), levels, gains, numSamples);
+        else
+            kernels->curve (curve, levels, gains, numSamples);
+
+        return;
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto level = (float) std::abs (levels[i]);
+        gains[i] = table != nullptr ? table->lookup (level) : GainCurve::computeGain (level, curve);
+    }
+}
+
+// The input is the dry signal, and may be the same memory as the output
+template <typename SampleType>
+void LifterEngine::applyGains (const SampleType* input, SampleType* output, const SampleType* gains, int numSamples) const
+{
+    if constexpr (std::is_same_v<SampleType, float>)
+    {
+        kernels->apply (input, output, gains, mix, numSamples);
+    }
+    else if (mix >= 1.0f)
+    {
+        juce::FloatVectorOperations::multiply (output, input, gains, numSamples);
+    }
+    else
+    {
+        for (int i = 0; i < numSamples; ++i)
+            output[i] = input[i] * (1.0 + mix * (gains[i] - 1.0));
+    }
+}
+
+// Ballistics run in double whatever the sample type: at long releases and high rates
+// the coefficient is within 1e-6 of 1, which float cannot resolve
+template <typename SampleType>
+double LifterEngine::runBallistics (double g, SampleType* gains, int numSamples) const noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto target = (double) gains[i];
+        const auto coeff = target < g ? attackCoeff : releaseCoeff;
+        g = target + coeff * (g - target);
+        gains[i] = (SampleType) g;
+    }
+
+    return g;
+}
+
+template <typename SampleType>
+void LifterEngine::processFeedForward (const InputBlock<SampleType>& input, const OutputBlock<SampleType>& output, int numChannels, const GainCurve::Table* table)
+{
+    const auto numSamples = (int) output.getNumSamples();
+    auto* gains = getScratch<SampleType>().gains.data();
+    auto& truePeak = getTruePeak<SampleType>();
+
+    for (int start = 0; start < numSamples; start += scratchSize)
+    {
+        const auto length = juce::jmin (scratchSize, numSamples - start);
+
+        if (truePeak.isActive())
+            truePeak.process (input, start, numChannels, length);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const auto* in = input.getChannelPointer ((size_t) ch) + start;
+
+            // 1. Measure the input and look up the target gains
+            computeGains (table, truePeak.isActive() ? truePeak.getLevels (ch) : in, gains, length);
+
+            // 2. Ballistics, in place over the targets
+            const auto g = runBallistics (gain[(size_t) ch], gains, length);
+            gain[(size_t) ch] = g;
+
+            // Keep the feed-back sidechain valid in case the topology switches
+            sidechain[(size_t) ch] = std::abs (in[length - 1] * g) * inverseMakeupGain;
+
+            // 3. Apply and mix
+            applyGains (in, output.getChannelPointer ((size_t) ch) + start, gains, length);
+        }
+    }
+}
+
+template <typename SampleType>
+void LifterEngine::processLinkedFeedForward (const InputBlock<SampleType>& input, const OutputBlock<SampleType>& output, int numChannels, const GainCurve::Table* table)
+{
+    const auto numSamples = (int) output.getNumSamples();
+    auto* gains = getScratch<SampleType>().gains.data();
+    auto* levels = getScratch<SampleType>().levels.data();
+    auto& truePeak = getTruePeak<SampleType>();
+
+    for (int start = 0; start < numSamples; start += scratchSize)
+    {
+        const auto length = juce::jmin (scratchSize, numSamples - start);
+
+        if (truePeak.isActive())
+            truePeak.process (input, start, numChannels, length);
+
+        auto getInput = [&] (int ch) { return truePeak.isActive() ? truePeak.getLevels (ch) : input.getChannelPointer ((size_t) ch) + start; };
+
+        // 1. Combine all channels into one sidechain
+        if (link == Link::max)
+        {
+            juce::FloatVectorOperations::abs (levels, getInput (0), length);
+
+            for (int ch = 1; ch < numChannels; ++ch)
+            {
+                juce::FloatVectorOperations::abs (gains, getInput (ch), length);
+                juce::FloatVectorOperations::max (levels, levels, gains, length);
+            }
+        }
+        else
+        {
+            juce::FloatVectorOperations::clear (levels, length);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                const auto* data = getInput (ch);
+                juce::FloatVectorOperations::addWithMultiply (levels, data, data, length);
+            }
+
+            const auto scale = (SampleType) 1 / (SampleType) numChannels;
+            for (int i = 0; i < length; ++i)
+                levels[i] = std::sqrt (levels[i] * scale);
+        }
+
+        // 2. One curve lookup and one set of ballistics for every channel
+        computeGains (table, levels, gains, length);
+        linkedGain = runBallistics (linkedGain, gains, length);
+        linkedSidechain = levels[length - 1] * gains[length - 1] * inverseMakeupGain;
+
+        // 3. Apply and mix
+        for (int ch = 0; ch < numChannels; ++ch)
+            applyGains (input.getChannelPointer ((size_t) ch) + start, output.getChannelPointer ((size_t) ch) + start, gains, length);
+    }
+}
+
+template <typename SampleType, typename CurveFunction>
+void LifterEngine::processFeedBack (const InputBlock<SampleType>& input, const OutputBlock<SampleType>& output, int numChannels, CurveFunction&& computeTarget)
+{
+    const auto numSamples = (int) output.getNumSamples();
+    const auto wetOnly = mix >= 1.0f;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto* in = input.getChannelPointer ((size_t) ch);
+        auto* out = output.getChannelPointer ((size_t) ch);
+        auto g = gain[(size_t) ch];
+        auto level = sidechain[(size_t) ch];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto dry = in[i];
+
+            // 1. Measure the previous output, 2. compute the gain and run the ballistics
+            const auto target = (double) computeTarget ((float) level);
+            const auto coeff = target < g ? attackCoeff : releaseCoeff;
+            g = target + coeff * (g - target);
+
+            // 3. Apply it, keeping the pre-makeup output for the next sample's sidechain
+            const auto wet = dry * (SampleType) g;
+            level = std::abs (wet) * inverseMakeupGain;
+            out[i] = wetOnly ? wet : dry + (SampleType) mix * (wet - dry);
+        }
+
+        gain[(size_t) ch] = g;
+        sidechain[(size_t) ch] = level;
+    }
+}
+
+template <typename SampleType, typename CurveFunction>
+void LifterEngine::processLinkedFeedBack (const InputBlock<SampleType>& input, const OutputBlock<SampleType>& output, int numChannels, CurveFunction&& computeTarget)
+{
+    const auto numSamples = (int) output.getNumSamples();
+    const auto wetOnly = mix >= 1.0f;
+    const auto scale = 1.0 / (double) numChannels;
+    auto g = linkedGain;
+    auto level = linkedSidechain;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // 1. Measure the previous output, 2. compute the gain and run the ballistics once
+        const auto target = (double) computeTarget ((float) level);
+        const auto coeff = target < g ? attackCoeff : releaseCoeff;
+        g = target + coeff * (g - target);
+
+        // 3. Apply it to every channel and combine their outputs for the next sample
+        auto combined = 0.0;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const auto dry = input.getSample (ch, i);
+            const auto wet = dry * (SampleType) g;
+            combined = link == Link::max ? juce::jmax (combined, (double) std::abs (wet)) : combined + (double) (wet * wet);
+            output.getChannelPointer ((size_t) ch)[i] = wetOnly ? wet : dry + (SampleType) mix * (wet - dry);
+        }
+
+        level = (link == Link::max ? combined : std::sqrt (combined * scale)) * inverseMakeupGain;
+    }
+
+    linkedGain = g;
+    linkedSidechain = level;
+}
+
+//==============================================================================
+template <typename SampleType>
+void LifterEngine::processControlRate (const InputBlock<SampleType>& input, const OutputBlock<SampleType>& output, int numChannels, const GainCurve::Table* table)
+{
+    const auto numSamples = (int) output.getNumSamples();
+    auto* ramp = getScratch<SampleType>().gains.data();
+
+    auto getPeak = [] (const SampleType* data, int length)
+    {
+        const auto range = juce::FloatVectorOperations::findMinAndMax (data, length);
+        return (double) juce::jmax (-range.getStart(), range.getEnd());
+    };
+
+    // Periods run on across calls. A call that starts or ends inside a period carries on its
+    // ramp, and the peak of the part measured after the control point goes into the next one.
+    for (int start = 0; start < numSamples;)
+    {
+        const auto startsPeriod = controlPhase == 0;
+        const auto length = juce::jmin (controlInterval - controlPhase, numSamples - start);
+
+        if (link == Link::perChannel)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                const auto c = (size_t) ch;
+                const auto* in = input.getChannelPointer (c) + start;
+                const auto peak = getPeak (in, length);
+                auto g = gain[c];
+
+                if (startsPeriod)
+                {
+                    // 1. Measure the period (or the previous period's output), 2. one curve and ballistics step
+                    const auto level = feedForward ? juce::jmax (peak, pendingPeak[c]) : sidechain[c];
+                    rampStep[c] = (getControlPoint (g, level, table) - g) / (double) controlInterval;
+                    pendingPeak[c] = 0.0;
+                    sidechain[c] = 0.0;
+                }
+                else
+                {
+                    pendingPeak[c] = juce::jmax (pendingPeak[c], peak);
+                }
+
+                g = fillRamp (g, rampStep[c], ramp, length);
+                gain[c] = g;
+                sidechain[c] = juce::jmax (sidechain[c], peak * g * inverseMakeupGain);
+
+                // 3. Apply the ramp and mix
+                applyGains (in, output.getChannelPointer (c) + start, ramp, length);
+            }
+        }
+        else
+        {
+            // 1. Combine the channel peaks into one sidechain. Per channel, so the RMS average
+            // of a period split across calls still sees each channel's peak over all of it.
+            auto combined = 0.0, combinedPart = 0.0;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                const auto c = (size_t) ch;
+                const auto partPeak = getPeak (input.getChannelPointer (c) + start, length);
+                const auto peak = startsPeriod ? juce::jmax (partPeak, pendingPeak[c]) : partPeak;
+
+                combined = link == Link::max ? juce::jmax (combined, peak) : combined + peak * peak;
+                combinedPart = link == Link::max ? juce::jmax (combinedPart, partPeak) : combinedPart + partPeak * partPeak;
+                pendingPeak[c] = startsPeriod ? 0.0 : juce::jmax (pendingPeak[c], partPeak);
+            }
+
+            const auto toLevel = [this, numChannels] (double sum) { return link == Link::max ? sum : std::sqrt (sum / (double) numChannels); };
+
+            // 2. One curve and ballistics step for every channel
+            if (startsPeriod)
+            {
+                const auto level = feedForward ? toLevel (combined) : linkedSidechain;
+                linkedRampStep = (getControlPoint (linkedGain, level, table) - linkedGain) / (double) controlInterval;
+                linkedSidechain = 0.0;
+            }
+
+            linkedGain = fillRamp (linkedGain, linkedRampStep, ramp, length);
+            linkedSidechain = juce::jmax (linkedSidechain, toLevel (combinedPart) * linkedGain * inverseMakeupGain);
+
+            // 3. Apply the ramp and mix
+            for (int ch = 0; ch < numChannels; ++ch)
+                applyGains (input.getChannelPointer ((size_t) ch) + start, output.getChannelPointer ((size_t) ch) + start, ramp, length);
+        }
+
+        start += length;
+        controlPhase = (controlPhase + length) % controlInterval;
+    }
+}
+
+double LifterEngine::getControlPoint (double g, double level, const GainCurve::Table* table) const noexcept
+{
+    const auto target = (double) (table != nullptr ? table->lookup ((float) level) : GainCurve::computeGain ((float) level, curve));
+
+    // Every period is a whole one, so the coefficients raised to the N are all it needs
+    const auto coeff = target < g ? controlAttackCoeff : controlReleaseCoeff;
+    return target + coeff * (g - target);
+}
+
+template <typename SampleType>
+double LifterEngine::fillRamp (double g, double step, SampleType* ramp, int length) noexcept
+{
+    // Linear ramp from the last value, landing on the control point at the end of the period
+    for (int i = 0; i < length; ++i)
+        ramp[i] = (SampleType) (g + step * (double) (i + 1));
+
+    return g + step * (double) length;
+}
+
+
+//==============================================================================
+template void LifterEngine::process (const juce::dsp::ProcessContextReplacing<float>&);
+template void LifterEngine::process (const juce::dsp::ProcessContextReplacing<double>&);
+template void LifterEngine::process (const juce::dsp::ProcessContextNonReplacing<float>&);
+template void LifterEngine::process (const juce::dsp::ProcessContextNonReplacing<double>&);
+template void LifterEngine::process (juce::AudioBuffer<float>&);
+template void LifterEngine::process (juce::AudioBuffer<double>&);
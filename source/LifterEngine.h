@@ -0,0 +1,212 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "BackgroundThread.h"
+#include "CurveCache.h"
+#include "GainCurve.h"
+#include "LifterKernels.h"
+#include "TripleBuffer.h"
+#include "TruePeakDetector.h"
+
+//==============================================================================
+// Plugin-side implementation of the Lifter model (identify sidechain, measure it,
+// compute the gain addition, apply it) with the same update* interface as punk_dsp::Lifter.
+// The processor runs it instead of punk_dsp::Lifter when one of the optimised modes is on.
+//
+// Gain is smoothed in the linear domain, so makeup commutes with the ballistics and
+// can live in the curve table together with threshold, ratio and knee.
+//
+// Feed-forward splits the work into stages: measure and look up the gain for a slice,
+// run the ballistics, then apply and mix. For float the first and last stages are vectorised (see LifterKernels).
+// The mix reads the dry signal from the input block, and at 100 % it is skipped altogether.
+// Feed-back needs each output sample before the next gain, so it runs sample by sample.
+//
+// Float and double buffers run through the same templates. The envelope and the ballistics
+// coefficients are double for both, since float cannot resolve long releases at high rates.
+//
+// Detector state is held per channel in flat arrays. In the linked modes one detector is fed
+// from all channels and its gain drives every channel, so the curve and ballistics run once.
+//
+// In eco mode the detector and gain computer run once per control period of N samples, on the
+// peak of that period, and the gain is ramped linearly between control points. Ballistics use
+// the per-sample coefficients raised to the N, so attack and release times stay the same.
+// Periods run on across calls, so short calls (the 16-sample parameter ramps) cost the same.
+//
+// With true-peak detection on, the feed-forward detector measures an oversampled copy of the
+// input (see TruePeakDetector) while the audio stays at the base rate. Feed-back measures its
+// own output sample by sample, and eco mode the peak of each control period, so both keep
+// measuring sample peaks.
+class LifterEngine : private juce::TimeSliceClient
+{
+public:
+    enum class Link
+    {
+        perChannel, // Independent detector per channel
+        max,        // Loudest channel drives all of them
+        rms         // RMS average across channels drives all of them
+    };
+
+    LifterEngine();
+    ~LifterEngine() override;
+
+    void prepare (const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    void updateRatio (float newRatio);
+    void updateRange (float newThres);
+    void updateKnee (float newKnee);
+    void updateAttack (float newAttackMs);
+    void updateRelease (float newReleaseMs);
+    void updateMakeUp (float newMakeupDb);
+    void updateFeedForward (bool shouldFeedForward);
+    void updateMix (float newMixPercent);
+
+    // Steps of a ramp towards the last updateRange/updateMakeUp value. The curve follows them
+    // exactly, but no table is built for the values in between: the one for the target is.
+    void rampRange (float thres) noexcept { curve.thres = thres; }
+    void rampMakeUp (float makeupDb) noexcept;
+
+    // Exact curve, or a table that is fetched on the background thread when the curve changes.
+    // Until a table for the current curve is ready, and for the whole of a ramp, the exact curve runs.
+    void setCurveResolution (GainCurve::Resolution newResolution);
+
+    // Vector kernels for the feed-forward path, picked for this CPU by default.
+    // Pass LifterKernels::getScalar() to run the reference path, e.g. for null tests.
+    void setKernels (const LifterKernels::Set& newKernels) noexcept { kernels = &newKernels; }
+
+    void setLink (Link newLink) noexcept { link = newLink; }
+
+    // Samples per control period, 1 runs the detector on every sample
+    void setControlInterval (int newInterval);
+
+    // Sidechain oversampling for inter-sample peaks: 1 (off), 2 or 4
+    void setTruePeakFactor (int newFactor);
+
+    // ProcessContextReplacing or ProcessContextNonReplacing, float or double. Out of place, the
+    // input block is only read and doubles as the dry signal for the mix, so the caller's
+    // memory is used as it is and nothing is copied. Output channels past the input's are cleared.
+    // The envelope is kept in double either way.
+    template <typename ProcessContext>
+    void process (const ProcessContext& context);
+
+    // In place, the same as a ProcessContextReplacing over the whole buffer
+    template <typename SampleType>
+    void process (juce::AudioBuffer<SampleType>& buffer);
+
+    float getGainAddition() const noexcept { return gainAddition; }
+
+    // Output/input gain the last block ended on, makeup and dry/wet mix included. Only
+    // meaningful once the detector has settled, when every channel has the same gain.
+    float getAppliedGain() const noexcept { return 1.0f + mix * (juce::Decibels::decibelsToGain (gainAddition) * makeupGain - 1.0f); }
+
+private:
+    int useTimeSlice() override;
+    void rebuildTable (juce::uint32 version);
+    void curveChanged() noexcept { curveVersion.fetch_add (1, std::memory_order_release); }
+
+    template <typename SampleType>
+    using InputBlock = juce::dsp::AudioBlock<const SampleType>;
+    template <typename SampleType>
+    using OutputBlock = juce::dsp::AudioBlock<SampleType>;
+
+    template <typename SampleType>
+    void processFeedForward (const InputBlock<SampleType>& input, const OutputBlock<SampleType>& output, int numChannels, const GainCurve::Table* table);
+    template <typename SampleType>
+    void processLinkedFeedForward (const InputBlock<SampleType>& input, const OutputBlock<SampleType>& output, int numChannels, const GainCurve::Table* table);
+
+    template <typename SampleType, typename CurveFunction>
+    void processFeedBack (const InputBlock<SampleType>& input, const OutputBlock<SampleType>& output, int numChannels, CurveFunction&& computeTarget);
+
+    template <typename SampleType, typename CurveFunction>
+    void processLinkedFeedBack (const InputBlock<SampleType>& input, const OutputBlock<SampleType>& output, int numChannels, CurveFunction&& computeTarget);
+
+    template <typename SampleType>
+    void processControlRate (const InputBlock<SampleType>& input, const OutputBlock<SampleType>& output, int numChannels, const GainCurve::Table* table);
+    double getControlPoint (double g, double level, const GainCurve::Table* table) const noexcept;
+    template <typename SampleType>
+    static double fillRamp (double g, double step, SampleType* ramp, int length) noexcept;
+    void updateControlCoefficients() noexcept;
+
+    template <typename SampleType>
+    void computeGains (const GainCurve::Table* table, const SampleType* levels, SampleType* gains, int numSamples);
+    template <typename SampleType>
+    void applyGains (const SampleType* input, SampleType* output, const SampleType* gains, int numSamples) const;
+    template <typename SampleType>
+    double runBallistics (double g, SampleType* gains, int numSamples) const noexcept;
+
+    juce::SharedResourcePointer<BackgroundThread> backgroundThread;
+
+    // Curve settings as seen by the table builder
+    std::atomic<float> sharedRatio { 4.0f }, sharedThres { -40.0f }, sharedKnee { 12.0f }, sharedMakeup { 0.0f };
+    std::atomic<GainCurve::Resolution> resolution { GainCurve::Resolution::exact };
+    std::atomic<juce::uint32> curveVersion { 0 }, builtVersion { 0 };
+    juce::CriticalSection builderLock;
+
+    // Tables come from the process-wide cache. Only the background thread swaps the references,
+    // so the audio thread never releases one.
+    juce::SharedResourcePointer<CurveCache> curveCache;
+    TripleBuffer<CurveCache::Ptr> tables;
+
+    // Audio thread state
+    GainCurve::Settings curve;
+    double sampleRate = 44100.0;
+    float attackMs = 15.0f, releaseMs = 60.0f;
+    double attackCoeff = 0.0, releaseCoeff = 0.0;
+    double controlAttackCoeff = 0.0, controlReleaseCoeff = 0.0;
+    int controlInterval = 1;
+    float makeupGain = 1.0f, inverseMakeupGain = 1.0f;
+    float mix = 1.0f;
+    bool feedForward = true;
+    Link link = Link::perChannel;
+
+    // Per channel detector state
+    std::vector<double> gain, sidechain;
+    float gainAddition = 0.0f;
+
+    // Shared detector state for the linked modes
+    double linkedGain = 1.0, linkedSidechain = 0.0;
+
+    // Eco mode state carried from one call to the next: the position in the control period, the
+    // slope of each ramp, and the input peaks of the part of a period after its control point
+    int controlPhase = 0;
+    std::vector<double> rampStep, pendingPeak;
+    double linkedRampStep = 0.0;
+
+    // Feed-forward runs stage by stage over slices of this many samples
+    static constexpr int scratchSize = 256;
+
+    template <typename SampleType>
+    struct Scratch
+    {
+        void allocate (int size) { gains.resize ((size_t) size); levels.resize ((size_t) size); }
+        std::vector<SampleType> gains, levels;
+    };
+
+    Scratch<float> floatScratch;
+    Scratch<double> doubleScratch;
+
+    TruePeakDetector<float> floatTruePeak;
+    TruePeakDetector<double> doubleTruePeak;
+
+    template <typename SampleType>
+    TruePeakDetector<SampleType>& getTruePeak() noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+            return floatTruePeak;
+        else
+            return doubleTruePeak;
+    }
+
+    template <typename SampleType>
+    Scratch<SampleType>& getScratch() noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+            return floatScratch;
+        else
+            return doubleScratch;
+    }
+
+    const LifterKernels::Set* kernels = &LifterKernels::getBest();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LifterEngine)
+};
@@ -0,0 +1,473 @@
+#include "LifterKernels.h"
+
+#if JUCE_INTEL
+    #include <immintrin.h>
+
+    // AVX2 code is compiled per function, so the rest of the build keeps the baseline instruction set
+    #if JUCE_MSVC
+        #define LIFTER_AVX2_TARGET
+    #else
+        #define LIFTER_AVX2_TARGET __attribute__ ((target ("avx2")))
+    #endif
+#elif JUCE_ARM && (defined (__ARM_NEON) || defined (__ARM_NEON__) || defined (_M_ARM64))
+    #include <arm_neon.h>
+    #define LIFTER_HAS_NEON 1
+#endif
+
+namespace LifterKernels
+{
+    //==============================================================================
+    // The exact curve without branches, in nepers (natural log units) at both ends:
+    //   levelDb  = max (ln (level) * dbPerNeper, levelFloorDb), over = levelDb - thres
+    //   gainDb   = kneeScale * (clamp (over, -halfKnee, halfKnee) - halfKnee)^2
+    //            - slope * min (over + halfKnee, 0) + makeup
+    //   gain     = exp (gainDb * nepersPerDb)
+    // which is computeGainAdditionDb() with its three regions folded into one expression.
+    namespace Curve
+    {
+        constexpr float dbPerNeper = 8.685889638f;    // 20 / ln 10
+        constexpr float nepersPerDb = 0.1151292546f;  // ln 10 / 20
+        constexpr float log2e = 1.442695041f;
+        constexpr float sqrt2 = 1.414213562f;
+
+        // ln 2 split in two, so e * ln2Hi is exact for any float exponent e
+        constexpr float ln2Hi = 0.693359375f;
+        constexpr float ln2Lo = -2.12194440e-4f;
+
+        // Cephes logf: ln (1 + x) = x - x^2 / 2 + x^3 * P (x) for x in [sqrt (0.5) - 1, sqrt (2) - 1]
+        constexpr std::array<float, 9> logPoly { 7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f, -1.2420140846e-1f, 1.4249322787e-1f,
+                                                 -1.6668057665e-1f, 2.0000714765e-1f, -2.4999993993e-1f, 3.3333331174e-1f };
+
+        // Cephes expf: exp (r) = 1 + r + r^2 * P (r) for r in [-ln 2 / 2, ln 2 / 2]
+        constexpr std::array<float, 6> expPoly { 1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f, 4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f };
+
+        // Gains are kept where exp() stays a normal float
+        constexpr float minNepers = -87.0f, maxNepers = 88.0f;
+
+        // Rounds t (> -128) to the nearest integer with a truncating conversion
+        constexpr float roundBias = 128.5f;
+        constexpr int roundOffset = 128;
+
+        struct Coefficients
+        {
+            explicit Coefficients (const GainCurve::Settings& s) noexcept
+                : thres (s.thres), makeup (s.makeup), slope (1.0f - 1.0f / s.ratio),
+                  halfKnee (0.5f * s.knee), kneeScale (slope / (2.0f * s.knee)) {}
+
+            float thres, makeup, slope, halfKnee, kneeScale;
+        };
+    }
+
+    //==============================================================================
+    // Scalar reference
+    static void lookupScalar (const GainCurve::TableView& table, const float* input, float* gains, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            gains[i] = table.lookup (std::abs (input[i]));
+    }
+
+    static void applyScalar (const float* input, float* output, const float* gains, float mix, int numSamples)
+    {
+        if (mix >= 1.0f)
+        {
+            for (int i = 0; i < numSamples; ++i)
+                output[i] = input[i] * gains[i];
+            return;
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+            output[i] = input[i] * (1.0f + mix * (gains[i] - 1.0f));
+    }
+
+    static void curveScalar (const GainCurve::Settings& settings, const float* input, float* gains, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            gains[i] = GainCurve::computeGain (std::abs (input[i]), settings);
+    }
+
+    static const Set scalarSet { "scalar", lookupScalar, applyScalar, curveScalar };
+
+    //==============================================================================
+   #if JUCE_INTEL
+    static void lookupSse2 (const GainCurve::TableView& table, const float* input, float* gains, int numSamples)
+    {
+        const auto absMask = _mm_castsi128_ps (_mm_set1_epi32 (0x7fffffff));
+        const auto minBits = _mm_set1_epi32 ((int) GainCurve::tableMinBits);
+        const auto range = _mm_set1_epi32 ((int) (GainCurve::tableMaxBits - GainCurve::tableMinBits));
+        const auto zero = _mm_setzero_si128();
+        const auto shift = _mm_cvtsi32_si128 ((int) table.shift);
+        const auto fractionMask = _mm_set1_epi32 ((int) table.fractionMask);
+        const auto fractionScale = _mm_set1_ps (table.fractionScale);
+        const auto* values = table.values;
+
+        alignas (16) std::int32_t index[4];
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            // Magnitudes are below 2^31 as integers, so signed compares clamp them correctly
+            auto offset = _mm_sub_epi32 (_mm_castps_si128 (_mm_and_ps (_mm_loadu_ps (input + i), absMask)), minBits);
+            offset = _mm_and_si128 (offset, _mm_cmpgt_epi32 (offset, zero));
+            const auto over = _mm_cmpgt_epi32 (offset, range);
+            offset = _mm_or_si128 (_mm_andnot_si128 (over, offset), _mm_and_si128 (over, range));
+
+            _mm_store_si128 (reinterpret_cast<__m128i*> (index), _mm_srl_epi32 (offset, shift));
+            const auto fraction = _mm_mul_ps (_mm_cvtepi32_ps (_mm_and_si128 (offset, fractionMask)), fractionScale);
+
+            const auto v0 = _mm_setr_ps (values[index[0]], values[index[1]], values[index[2]], values[index[3]]);
+            const auto v1 = _mm_setr_ps (values[index[0] + 1], values[index[1] + 1], values[index[2] + 1], values[index[3] + 1]);
+            _mm_storeu_ps (gains + i, _mm_add_ps (v0, _mm_mul_ps (fraction, _mm_sub_ps (v1, v0))));
+        }
+
+        lookupScalar (table, input + i, gains + i, numSamples - i);
+    }
+
+    static void applySse2 (const float* input, float* output, const float* gains, float mix, int numSamples)
+    {
+        const auto one = _mm_set1_ps (1.0f);
+        const auto mixVec = _mm_set1_ps (mix);
+        int i = 0;
+
+        if (mix >= 1.0f)
+        {
+            for (; i + 4 <= numSamples; i += 4)
+                _mm_storeu_ps (output + i, _mm_mul_ps (_mm_loadu_ps (input + i), _mm_loadu_ps (gains + i)));
+        }
+        else
+        {
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                const auto g = _mm_add_ps (one, _mm_mul_ps (mixVec, _mm_sub_ps (_mm_loadu_ps (gains + i), one)));
+                _mm_storeu_ps (output + i, _mm_mul_ps (_mm_loadu_ps (input + i), g));
+            }
+        }
+
+        applyScalar (input + i, output + i, gains + i, mix, numSamples - i);
+    }
+
+    static void curveSse2 (const GainCurve::Settings& settings, const float* input, float* gains, int numSamples)
+    {
+        using namespace Curve;
+        const Coefficients c (settings);
+
+        const auto absMask = _mm_castsi128_ps (_mm_set1_epi32 (0x7fffffff));
+        const auto mantissaMask = _mm_set1_epi32 (0x007fffff);
+        const auto oneBits = _mm_set1_epi32 (0x3f800000);
+        const auto exponentBias = _mm_set1_epi32 (127);
+        const auto minLevel = _mm_set1_ps (std::numeric_limits<float>::min());
+        const auto one = _mm_set1_ps (1.0f);
+        const auto half = _mm_set1_ps (0.5f);
+        const auto zero = _mm_setzero_ps();
+        const auto halfKnee = _mm_set1_ps (c.halfKnee);
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            // ln |x|: exponent and mantissa from the bits, the mantissa folded into [sqrt (0.5), sqrt (2))
+            const auto bits = _mm_castps_si128 (_mm_max_ps (_mm_and_ps (_mm_loadu_ps (input + i), absMask), minLevel));
+            auto e = _mm_cvtepi32_ps (_mm_sub_epi32 (_mm_srli_epi32 (bits, 23), exponentBias));
+            auto m = _mm_castsi128_ps (_mm_or_si128 (_mm_and_si128 (bits, mantissaMask), oneBits));
+            const auto high = _mm_cmpgt_ps (m, _mm_set1_ps (sqrt2));
+            m = _mm_or_ps (_mm_andnot_ps (high, m), _mm_and_ps (high, _mm_mul_ps (m, half)));
+            e = _mm_add_ps (e, _mm_and_ps (high, one));
+
+            const auto x = _mm_sub_ps (m, one);
+            const auto z = _mm_mul_ps (x, x);
+            auto p = _mm_set1_ps (logPoly[0]);
+            for (size_t k = 1; k < logPoly.size(); ++k)
+                p = _mm_add_ps (_mm_mul_ps (p, x), _mm_set1_ps (logPoly[k]));
+
+            auto y = _mm_add_ps (_mm_mul_ps (_mm_mul_ps (p, x), z), _mm_mul_ps (e, _mm_set1_ps (ln2Lo)));
+            y = _mm_sub_ps (y, _mm_mul_ps (half, z));
+            const auto ln = _mm_add_ps (_mm_add_ps (x, y), _mm_mul_ps (e, _mm_set1_ps (ln2Hi)));
+
+            // Curve, in dB
+            const auto levelDb = _mm_max_ps (_mm_mul_ps (ln, _mm_set1_ps (dbPerNeper)), _mm_set1_ps (GainCurve::levelFloorDb));
+            const auto over = _mm_sub_ps (levelDb, _mm_set1_ps (c.thres));
+            const auto kneeOffset = _mm_sub_ps (_mm_min_ps (_mm_max_ps (over, _mm_sub_ps (zero, halfKnee)), halfKnee), halfKnee);
+            auto gainDb = _mm_mul_ps (_mm_set1_ps (c.kneeScale), _mm_mul_ps (kneeOffset, kneeOffset));
+            gainDb = _mm_sub_ps (gainDb, _mm_mul_ps (_mm_set1_ps (c.slope), _mm_min_ps (_mm_add_ps (over, halfKnee), zero)));
+            gainDb = _mm_add_ps (gainDb, _mm_set1_ps (c.makeup));
+
+            // exp: 2^n from the exponent bits times exp (r) on the remainder
+            const auto nepers = _mm_min_ps (_mm_max_ps (_mm_mul_ps (gainDb, _mm_set1_ps (nepersPerDb)), _mm_set1_ps (minNepers)), _mm_set1_ps (maxNepers));
+            const auto n = _mm_sub_epi32 (_mm_cvttps_epi32 (_mm_add_ps (_mm_mul_ps (nepers, _mm_set1_ps (log2e)), _mm_set1_ps (roundBias))), _mm_set1_epi32 (roundOffset));
+            const auto nf = _mm_cvtepi32_ps (n);
+            const auto r = _mm_sub_ps (_mm_sub_ps (nepers, _mm_mul_ps (nf, _mm_set1_ps (ln2Hi))), _mm_mul_ps (nf, _mm_set1_ps (ln2Lo)));
+
+            auto q = _mm_set1_ps (expPoly[0]);
+            for (size_t j = 1; j < expPoly.size(); ++j)
+                q = _mm_add_ps (_mm_mul_ps (q, r), _mm_set1_ps (expPoly[j]));
+
+            q = _mm_add_ps (_mm_add_ps (_mm_mul_ps (q, _mm_mul_ps (r, r)), r), one);
+            const auto scale = _mm_castsi128_ps (_mm_slli_epi32 (_mm_add_epi32 (n, exponentBias), 23));
+            _mm_storeu_ps (gains + i, _mm_mul_ps (q, scale));
+        }
+
+        curveScalar (settings, input + i, gains + i, numSamples - i);
+    }
+
+    LIFTER_AVX2_TARGET static void lookupAvx2 (const GainCurve::TableView& table, const float* input, float* gains, int numSamples)
+    {
+        const auto absMask = _mm256_castsi256_ps (_mm256_set1_epi32 (0x7fffffff));
+        const auto minBits = _mm256_set1_epi32 ((int) GainCurve::tableMinBits);
+        const auto range = _mm256_set1_epi32 ((int) (GainCurve::tableMaxBits - GainCurve::tableMinBits));
+        const auto zero = _mm256_setzero_si256();
+        const auto shift = _mm_cvtsi32_si128 ((int) table.shift);
+        const auto fractionMask = _mm256_set1_epi32 ((int) table.fractionMask);
+        const auto fractionScale = _mm256_set1_ps (table.fractionScale);
+        const auto* values = table.values;
+        int i = 0;
+
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            auto offset = _mm256_sub_epi32 (_mm256_castps_si256 (_mm256_and_ps (_mm256_loadu_ps (input + i), absMask)), minBits);
+            offset = _mm256_min_epi32 (_mm256_max_epi32 (offset, zero), range);
+
+            const auto index = _mm256_srl_epi32 (offset, shift);
+            const auto fraction = _mm256_mul_ps (_mm256_cvtepi32_ps (_mm256_and_si256 (offset, fractionMask)), fractionScale);
+
+            const auto v0 = _mm256_i32gather_ps (values, index, 4);
+            const auto v1 = _mm256_i32gather_ps (values + 1, index, 4);
+            _mm256_storeu_ps (gains + i, _mm256_add_ps (v0, _mm256_mul_ps (fraction, _mm256_sub_ps (v1, v0))));
+        }
+
+        lookupScalar (table, input + i, gains + i, numSamples - i);
+    }
+
+    LIFTER_AVX2_TARGET static void applyAvx2 (const float* input, float* output, const float* gains, float mix, int numSamples)
+    {
+        const auto one = _mm256_set1_ps (1.0f);
+        const auto mixVec = _mm256_set1_ps (mix);
+        int i = 0;
+
+        if (mix >= 1.0f)
+        {
+            for (; i + 8 <= numSamples; i += 8)
+                _mm256_storeu_ps (output + i, _mm256_mul_ps (_mm256_loadu_ps (input + i), _mm256_loadu_ps (gains + i)));
+        }
+        else
+        {
+            for (; i + 8 <= numSamples; i += 8)
+            {
+                const auto g = _mm256_add_ps (one, _mm256_mul_ps (mixVec, _mm256_sub_ps (_mm256_loadu_ps (gains + i), one)));
+                _mm256_storeu_ps (output + i, _mm256_mul_ps (_mm256_loadu_ps (input + i), g));
+            }
+        }
+
+        applyScalar (input + i, output + i, gains + i, mix, numSamples - i);
+    }
+
+    LIFTER_AVX2_TARGET static void curveAvx2 (const GainCurve::Settings& settings, const float* input, float* gains, int numSamples)
+    {
+        using namespace Curve;
+        const Coefficients c (settings);
+
+        const auto absMask = _mm256_castsi256_ps (_mm256_set1_epi32 (0x7fffffff));
+        const auto mantissaMask = _mm256_set1_epi32 (0x007fffff);
+        const auto oneBits = _mm256_set1_epi32 (0x3f800000);
+        const auto exponentBias = _mm256_set1_epi32 (127);
+        const auto minLevel = _mm256_set1_ps (std::numeric_limits<float>::min());
+        const auto one = _mm256_set1_ps (1.0f);
+        const auto half = _mm256_set1_ps (0.5f);
+        const auto zero = _mm256_setzero_ps();
+        const auto halfKnee = _mm256_set1_ps (c.halfKnee);
+        int i = 0;
+
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            // ln |x|, as in curveSse2
+            const auto bits = _mm256_castps_si256 (_mm256_max_ps (_mm256_and_ps (_mm256_loadu_ps (input + i), absMask), minLevel));
+            auto e = _mm256_cvtepi32_ps (_mm256_sub_epi32 (_mm256_srli_epi32 (bits, 23), exponentBias));
+            auto m = _mm256_castsi256_ps (_mm256_or_si256 (_mm256_and_si256 (bits, mantissaMask), oneBits));
+            const auto high = _mm256_cmp_ps (m, _mm256_set1_ps (sqrt2), _CMP_GT_OQ);
+            m = _mm256_blendv_ps (m, _mm256_mul_ps (m, half), high);
+            e = _mm256_add_ps (e, _mm256_and_ps (high, one));
+
+            const auto x = _mm256_sub_ps (m, one);
+            const auto z = _mm256_mul_ps (x, x);
+            auto p = _mm256_set1_ps (logPoly[0]);
+            for (size_t k = 1; k < logPoly.size(); ++k)
+                p = _mm256_add_ps (_mm256_mul_ps (p, x), _mm256_set1_ps (logPoly[k]));
+
+            auto y = _mm256_add_ps (_mm256_mul_ps (_mm256_mul_ps (p, x), z), _mm256_mul_ps (e, _mm256_set1_ps (ln2Lo)));
+            y = _mm256_sub_ps (y, _mm256_mul_ps (half, z));
+            const auto ln = _mm256_add_ps (_mm256_add_ps (x, y), _mm256_mul_ps (e, _mm256_set1_ps (ln2Hi)));
+
+            // Curve, in dB
+            const auto levelDb = _mm256_max_ps (_mm256_mul_ps (ln, _mm256_set1_ps (dbPerNeper)), _mm256_set1_ps (GainCurve::levelFloorDb));
+            const auto over = _mm256_sub_ps (levelDb, _mm256_set1_ps (c.thres));
+            const auto kneeOffset = _mm256_sub_ps (_mm256_min_ps (_mm256_max_ps (over, _mm256_sub_ps (zero, halfKnee)), halfKnee), halfKnee);
+            auto gainDb = _mm256_mul_ps (_mm256_set1_ps (c.kneeScale), _mm256_mul_ps (kneeOffset, kneeOffset));
+            gainDb = _mm256_sub_ps (gainDb, _mm256_mul_ps (_mm256_set1_ps (c.slope), _mm256_min_ps (_mm256_add_ps (over, halfKnee), zero)));
+            gainDb = _mm256_add_ps (gainDb, _mm256_set1_ps (c.makeup));
+
+            // exp, as in curveSse2
+            const auto nepers = _mm256_min_ps (_mm256_max_ps (_mm256_mul_ps (gainDb, _mm256_set1_ps (nepersPerDb)), _mm256_set1_ps (minNepers)), _mm256_set1_ps (maxNepers));
+            const auto n = _mm256_sub_epi32 (_mm256_cvttps_epi32 (_mm256_add_ps (_mm256_mul_ps (nepers, _mm256_set1_ps (log2e)), _mm256_set1_ps (roundBias))), _mm256_set1_epi32 (roundOffset));
+            const auto nf = _mm256_cvtepi32_ps (n);
+            const auto r = _mm256_sub_ps (_mm256_sub_ps (nepers, _mm256_mul_ps (nf, _mm256_set1_ps (ln2Hi))), _mm256_mul_ps (nf, _mm256_set1_ps (ln2Lo)));
+
+            auto q = _mm256_set1_ps (expPoly[0]);
+            for (size_t j = 1; j < expPoly.size(); ++j)
+                q = _mm256_add_ps (_mm256_mul_ps (q, r), _mm256_set1_ps (expPoly[j]));
+
+            q = _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (q, _mm256_mul_ps (r, r)), r), one);
+            const auto scale = _mm256_castsi256_ps (_mm256_slli_epi32 (_mm256_add_epi32 (n, exponentBias), 23));
+            _mm256_storeu_ps (gains + i, _mm256_mul_ps (q, scale));
+        }
+
+        curveScalar (settings, input + i, gains + i, numSamples - i);
+    }
+
+    static const Set sse2Set { "sse2", lookupSse2, applySse2, curveSse2 };
+    static const Set avx2Set { "avx2", lookupAvx2, applyAvx2, curveAvx2 };
+   #endif
+
+    //==============================================================================
+   #if LIFTER_HAS_NEON
+    static void lookupNeon (const GainCurve::TableView& table, const float* input, float* gains, int numSamples)
+    {
+        const auto minBits = vdupq_n_u32 (GainCurve::tableMinBits);
+        const auto range = vdupq_n_u32 (GainCurve::tableMaxBits - GainCurve::tableMinBits);
+        const auto shift = vdupq_n_s32 (-(int) table.shift);
+        const auto fractionMask = vdupq_n_u32 (table.fractionMask);
+        const auto fractionScale = vdupq_n_f32 (table.fractionScale);
+        const auto* values = table.values;
+
+        alignas (16) std::uint32_t index[4];
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            // Saturating subtract clamps levels below the table to the first node
+            const auto bits = vreinterpretq_u32_f32 (vabsq_f32 (vld1q_f32 (input + i)));
+            const auto offset = vminq_u32 (vqsubq_u32 (bits, minBits), range);
+
+            vst1q_u32 (index, vshlq_u32 (offset, shift));
+            const auto fraction = vmulq_f32 (vcvtq_f32_u32 (vandq_u32 (offset, fractionMask)), fractionScale);
+
+            alignas (16) const float lower[] { values[index[0]], values[index[1]], values[index[2]], values[index[3]] };
+            alignas (16) const float upper[] { values[index[0] + 1], values[index[1] + 1], values[index[2] + 1], values[index[3] + 1] };
+            const auto v0 = vld1q_f32 (lower);
+            const auto v1 = vld1q_f32 (upper);
+            vst1q_f32 (gains + i, vaddq_f32 (v0, vmulq_f32 (fraction, vsubq_f32 (v1, v0))));
+        }
+
+        lookupScalar (table, input + i, gains + i, numSamples - i);
+    }
+
+    static void applyNeon (const float* input, float* output, const float* gains, float mix, int numSamples)
+    {
+        const auto one = vdupq_n_f32 (1.0f);
+        const auto mixVec = vdupq_n_f32 (mix);
+        int i = 0;
+
+        if (mix >= 1.0f)
+        {
+            for (; i + 4 <= numSamples; i += 4)
+                vst1q_f32 (output + i, vmulq_f32 (vld1q_f32 (input + i), vld1q_f32 (gains + i)));
+        }
+        else
+        {
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                const auto g = vaddq_f32 (one, vmulq_f32 (mixVec, vsubq_f32 (vld1q_f32 (gains + i), one)));
+                vst1q_f32 (output + i, vmulq_f32 (vld1q_f32 (input + i), g));
+            }
+        }
+
+        applyScalar (input + i, output + i, gains + i, mix, numSamples - i);
+    }
+
+    static void curveNeon (const GainCurve::Settings& settings, const float* input, float* gains, int numSamples)
+    {
+        using namespace Curve;
+        const Coefficients c (settings);
+
+        const auto mantissaMask = vdupq_n_u32 (0x007fffff);
+        const auto oneBits = vdupq_n_u32 (0x3f800000);
+        const auto exponentBias = vdupq_n_s32 (127);
+        const auto minLevel = vdupq_n_f32 (std::numeric_limits<float>::min());
+        const auto one = vdupq_n_f32 (1.0f);
+        const auto zero = vdupq_n_f32 (0.0f);
+        const auto halfKnee = vdupq_n_f32 (c.halfKnee);
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            // ln |x|, as in curveSse2
+            const auto bits = vreinterpretq_u32_f32 (vmaxq_f32 (vabsq_f32 (vld1q_f32 (input + i)), minLevel));
+            auto e = vcvtq_f32_s32 (vsubq_s32 (vreinterpretq_s32_u32 (vshrq_n_u32 (bits, 23)), exponentBias));
+            auto m = vreinterpretq_f32_u32 (vorrq_u32 (vandq_u32 (bits, mantissaMask), oneBits));
+            const auto high = vcgtq_f32 (m, vdupq_n_f32 (sqrt2));
+            m = vbslq_f32 (high, vmulq_n_f32 (m, 0.5f), m);
+            e = vaddq_f32 (e, vreinterpretq_f32_u32 (vandq_u32 (high, vreinterpretq_u32_f32 (one))));
+
+            const auto x = vsubq_f32 (m, one);
+            const auto z = vmulq_f32 (x, x);
+            auto p = vdupq_n_f32 (logPoly[0]);
+            for (size_t k = 1; k < logPoly.size(); ++k)
+                p = vaddq_f32 (vmulq_f32 (p, x), vdupq_n_f32 (logPoly[k]));
+
+            auto y = vaddq_f32 (vmulq_f32 (vmulq_f32 (p, x), z), vmulq_n_f32 (e, ln2Lo));
+            y = vsubq_f32 (y, vmulq_n_f32 (z, 0.5f));
+            const auto ln = vaddq_f32 (vaddq_f32 (x, y), vmulq_n_f32 (e, ln2Hi));
+
+            // Curve, in dB
+            const auto levelDb = vmaxq_f32 (vmulq_n_f32 (ln, dbPerNeper), vdupq_n_f32 (GainCurve::levelFloorDb));
+            const auto over = vsubq_f32 (levelDb, vdupq_n_f32 (c.thres));
+            const auto kneeOffset = vsubq_f32 (vminq_f32 (vmaxq_f32 (over, vnegq_f32 (halfKnee)), halfKnee), halfKnee);
+            auto gainDb = vmulq_n_f32 (vmulq_f32 (kneeOffset, kneeOffset), c.kneeScale);
+            gainDb = vsubq_f32 (gainDb, vmulq_n_f32 (vminq_f32 (vaddq_f32 (over, halfKnee), zero), c.slope));
+            gainDb = vaddq_f32 (gainDb, vdupq_n_f32 (c.makeup));
+
+            // exp, as in curveSse2
+            const auto nepers = vminq_f32 (vmaxq_f32 (vmulq_n_f32 (gainDb, nepersPerDb), vdupq_n_f32 (minNepers)), vdupq_n_f32 (maxNepers));
+            const auto n = vsubq_s32 (vcvtq_s32_f32 (vaddq_f32 (vmulq_n_f32 (nepers, log2e), vdupq_n_f32 (roundBias))), vdupq_n_s32 (roundOffset));
+            const auto nf = vcvtq_f32_s32 (n);
+            const auto r = vsubq_f32 (vsubq_f32 (nepers, vmulq_n_f32 (nf, ln2Hi)), vmulq_n_f32 (nf, ln2Lo));
+
+            auto q = vdupq_n_f32 (expPoly[0]);
+            for (size_t j = 1; j < expPoly.size(); ++j)
+                q = vaddq_f32 (vmulq_f32 (q, r), vdupq_n_f32 (expPoly[j]));
+
+            q = vaddq_f32 (vaddq_f32 (vmulq_f32 (q, vmulq_f32 (r, r)), r), one);
+            const auto scale = vreinterpretq_f32_s32 (vshlq_n_s32 (vaddq_s32 (n, exponentBias), 23));
+            vst1q_f32 (gains + i, vmulq_f32 (q, scale));
+        }
+
+        curveScalar (settings, input + i, gains + i, numSamples - i);
+    }
+
+    static const Set neonSet { "neon", lookupNeon, applyNeon, curveNeon };
+   #endif
+
+    //==============================================================================
+    const Set& getScalar()
+    {
+        return scalarSet;
+    }
+
+    juce::Array<const Set*> getAvailable()
+    {
+        juce::Array<const Set*> sets { &scalarSet };
+
+       #if JUCE_INTEL
+        if (juce::SystemStats::hasSSE2())
+            sets.add (&sse2Set);
+        if (juce::SystemStats::hasAVX2())
+            sets.add (&avx2Set);
+       #elif LIFTER_HAS_NEON
+        sets.add (&neonSet);
+       #endif
+
+        return sets;
+    }
+
+    const Set& getBest()
+    {
+        static const Set& best = *getAvailable().getLast();
+        return best;
+    }
+}
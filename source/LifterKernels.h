@@ -0,0 +1,43 @@
+#pragma once
+
+#include "GainCurve.h"
+
+// Block kernels for the vectorisable stages of LifterEngine's feed-forward path.
+// The gain ballistics in between are a recursion on the previous sample, so they stay scalar.
+//
+// Every instruction set gets the same kernels, picked once at runtime. The vector lookup and
+// apply kernels run the same arithmetic as the scalar reference, in a different order under
+// fast-math, so outputs may differ from the scalar path by a few float ulps: at most 1e-6
+// relative to the input sample (-120 dB). The vector exact curve uses polynomial log and exp
+// (the Cephes logf/expf ones) where the scalar reference calls the C library, and stays within
+// 1e-5 of it relative to the gain (-100 dB). `LifterBenchmark --mode=simd` null-tests every
+// available set against the scalar one, with and without a table.
+namespace LifterKernels
+{
+    // Measure |input| and look up the target gain from the table
+    using LookupFunction = void (*) (const GainCurve::TableView& table, const float* input, float* gains, int numSamples);
+
+    // Measure |input| and compute the target gain on the exact curve, GainCurve::computeGain()
+    using CurveFunction = void (*) (const GainCurve::Settings& settings, const float* input, float* gains, int numSamples);
+
+    // Apply the gains and mix with the dry signal: output = input * (1 + mix * (gain - 1)).
+    // Input and output may be the same memory. At mix 1 the dry term is skipped: output = input * gain.
+    using ApplyFunction = void (*) (const float* input, float* output, const float* gains, float mix, int numSamples);
+
+    struct Set
+    {
+        const char* name;
+        LookupFunction lookup;
+        ApplyFunction apply;
+        CurveFunction curve;
+    };
+
+    // Reference implementation
+    const Set& getScalar();
+
+    // Fastest set this CPU supports: AVX2, SSE2, NEON or scalar
+    const Set& getBest();
+
+    // Every set this CPU supports, scalar first
+    juce::Array<const Set*> getAvailable();
+}
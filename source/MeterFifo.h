@@ -0,0 +1,48 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+// One decimated metering frame, as sent from the audio thread to the editor
+struct MeterFrame
+{
+    float gainAddition = 0.0f;  // dB
+    float inputPeak = 0.0f;     // linear
+    float outputPeak = 0.0f;    // linear
+};
+
+// Wait-free single-producer/single-consumer queue of meter frames.
+// The audio thread pushes, the editor drains. When the queue is full new frames are dropped,
+// so memory stays bounded and the audio thread never waits on the GUI.
+class MeterFifo
+{
+public:
+    static constexpr int capacity = 1024;
+    static constexpr int framesPerSecond = 100;
+
+    bool push (const MeterFrame& frame) noexcept
+    {
+        const auto scope = fifo.write (1);
+
+        if (scope.blockSize1 + scope.blockSize2 == 0)
+            return false;
+
+        scope.forEach ([this, &frame] (int index) { frames[(size_t) index] = frame; });
+        return true;
+    }
+
+    template <typename Callback>
+    int drain (Callback&& callback)
+    {
+        const auto scope = fifo.read (fifo.getNumReady());
+        scope.forEach ([this, &callback] (int index) { callback (frames[(size_t) index]); });
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    void reset() noexcept { fifo.reset(); }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<MeterFrame, capacity> frames {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MeterFifo)
+};
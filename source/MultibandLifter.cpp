@@ -0,0 +1,230 @@
+#include "MultibandLifter.h"
+
+void MultibandLifter::prepare (const juce::dsp::ProcessSpec& spec, int realtimeChunkSize, bool doublePrecision)
+{
+    sampleRate = spec.sampleRate;
+    numChannels = (int) spec.numChannels;
+    capacity = (int) spec.maximumBlockSize;
+    realtimeChunk = juce::jmin (realtimeChunkSize, capacity);
+
+    for (auto& band : bands)
+        band.prepare (spec);
+
+    for (auto& splitter : splitters)
+        splitter.prepare (spec);
+
+    for (auto& bandAllpasses : allpasses)
+    {
+        for (auto& allpass : bandAllpasses)
+        {
+            allpass.setType (juce::dsp::LinkwitzRileyFilterType::allpass);
+            allpass.prepare (spec);
+        }
+    }
+
+    updateCrossovers();
+
+    for (auto& buffer : floatBands)
+        buffer.setSize (doublePrecision ? 0 : numChannels, doublePrecision ? 0 : capacity);
+    for (auto& buffer : doubleBands)
+        buffer.setSize (doublePrecision ? numChannels : 0, doublePrecision ? capacity : 0);
+}
+
+void MultibandLifter::reset()
+{
+    for (auto& band : bands)
+        band.reset();
+
+    for (auto& splitter : splitters)
+        splitter.reset();
+
+    for (auto& bandAllpasses : allpasses)
+        for (auto& allpass : bandAllpasses)
+            allpass.reset();
+}
+
+void MultibandLifter::setCrossover (int index, float frequencyHz)
+{
+    crossoverHz[(size_t) index] = frequencyHz;
+    updateCrossovers();
+}
+
+void MultibandLifter::updateCrossovers()
+{
+    // At least a third of an octave apart, and clear of Nyquist
+    const auto maxHz = (float) sampleRate * 0.45f;
+    auto previous = 0.0f;
+
+    for (size_t j = 0; j < splitters.size(); ++j)
+    {
+        const auto hz = juce::jmin (maxHz, juce::jmax (crossoverHz[j], previous * 1.26f));
+        splitters[j].setCutoffFrequency (hz);
+
+        for (auto& bandAllpasses : allpasses)
+            bandAllpasses[j].setCutoffFrequency (hz);
+
+        previous = hz;
+    }
+}
+
+float MultibandLifter::getGainAddition() const noexcept
+{
+    auto gainAddition = 0.0f;
+
+    for (int b = 0; b < numBands; ++b)
+    {
+        const auto bandGainAddition = bands[(size_t) b].getGainAddition();
+
+        if (std::abs (bandGainAddition) > std::abs (gainAddition))
+            gainAddition = bandGainAddition;
+    }
+
+    return gainAddition;
+}
+
+float MultibandLifter::getTotalGainAddition() const noexcept
+{
+    auto total = 0.0f;
+
+    for (int b = 0; b < numBands; ++b)
+        total += bands[(size_t) b].getGainAddition();
+
+    return total;
+}
+
+//==============================================================================
+template <typename SampleType>
+void MultibandLifter::process (juce::AudioBuffer<SampleType>& buffer)
+{
+    processChunks (buffer, false);
+}
+
+template <typename SampleType>
+void MultibandLifter::processHeld (juce::AudioBuffer<SampleType>& buffer)
+{
+    processChunks (buffer, true);
+}
+
+template <typename SampleType>
+void MultibandLifter::processChunks (juce::AudioBuffer<SampleType>& buffer, bool holdGains)
+{
+    // Prepared for the other precision: pass the signal through untouched
+    if (getBandBuffers<SampleType>()[0].getNumSamples() == 0)
+        return;
+
+    const auto numSamples = buffer.getNumSamples();
+    const auto chunkSize = nonRealtime ? capacity : realtimeChunk;
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const auto length = juce::jmin (chunkSize, numSamples - start);
+
+        split (buffer, start, length);
+
+        if (holdGains)
+            applyHeldGains<SampleType> (length);
+        else
+            processBands<SampleType> (length);
+
+        sum (buffer, start, length);
+    }
+}
+
+template <typename SampleType>
+void MultibandLifter::split (const juce::AudioBuffer<SampleType>& buffer, int start, int length)
+{
+    auto& bandBuffers = getBandBuffers<SampleType>();
+    const auto lastBand = numBands - 1;
+
+    for (int ch = 0; ch < juce::jmin (numChannels, buffer.getNumChannels()); ++ch)
+    {
+        const auto* input = buffer.getReadPointer (ch, start);
+
+        std::array<SampleType*, maxBands> outputs {};
+        for (int b = 0; b < numBands; ++b)
+            outputs[(size_t) b] = bandBuffers[(size_t) b].getWritePointer (ch);
+
+        for (int i = 0; i < length; ++i)
+        {
+            auto rest = (double) input[i];
+
+            for (int k = 0; k < lastBand; ++k)
+            {
+                double low, high;
+                splitters[(size_t) k].processSample (ch, rest, low, high);
+
+                // Match the phase of the crossovers above this band
+                for (int j = k + 1; j < lastBand; ++j)
+                    low = allpasses[(size_t) k][(size_t) j].processSample (ch, low);
+
+                outputs[(size_t) k][i] = (SampleType) low;
+                rest = high;
+            }
+
+            outputs[(size_t) lastBand][i] = (SampleType) rest;
+        }
+    }
+}
+
+template <typename SampleType>
+void MultibandLifter::processBand (int band, int length)
+{
+    auto& bandBuffer = getBandBuffers<SampleType>()[(size_t) band];
+    juce::AudioBuffer<SampleType> view (bandBuffer.getArrayOfWritePointers(), numChannels, 0, length);
+    bands[(size_t) band].process (view);
+}
+
+template <typename SampleType>
+void MultibandLifter::processBands (int length)
+{
+    if (nonRealtime && length >= parallelThreshold && numBands > 1)
+    {
+        pendingLength = length;
+
+        workerPool->runAll ([] (void* context, int band)
+        {
+            auto& self = *static_cast<MultibandLifter*> (context);
+            self.processBand<SampleType> (band, self.pendingLength);
+        }, this, numBands);
+
+        return;
+    }
+
+    for (int b = 0; b < numBands; ++b)
+        processBand<SampleType> (b, length);
+}
+
+template <typename SampleType>
+void MultibandLifter::applyHeldGains (int length)
+{
+    auto& bandBuffers = getBandBuffers<SampleType>();
+
+    for (int b = 0; b < numBands; ++b)
+    {
+        const auto gain = (SampleType) bands[(size_t) b].getAppliedGain();
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            juce::FloatVectorOperations::multiply (bandBuffers[(size_t) b].getWritePointer (ch), gain, length);
+    }
+}
+
+template <typename SampleType>
+void MultibandLifter::sum (juce::AudioBuffer<SampleType>& buffer, int start, int length)
+{
+    auto& bandBuffers = getBandBuffers<SampleType>();
+
+    for (int ch = 0; ch < juce::jmin (numChannels, buffer.getNumChannels()); ++ch)
+    {
+        auto* output = buffer.getWritePointer (ch, start);
+        juce::FloatVectorOperations::copy (output, bandBuffers[0].getReadPointer (ch), length);
+
+        for (int b = 1; b < numBands; ++b)
+            juce::FloatVectorOperations::add (output, bandBuffers[(size_t) b].getReadPointer (ch), length);
+    }
+}
+
+//==============================================================================
+template void MultibandLifter::process (juce::AudioBuffer<float>&);
+template void MultibandLifter::process (juce::AudioBuffer<double>&);
+template void MultibandLifter::processHeld (juce::AudioBuffer<float>&);
+template void MultibandLifter::processHeld (juce::AudioBuffer<double>&);
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "LifterEngine.h"
+#include "WorkerPool.h"
+
+//==============================================================================
+// N-band Lifter: Linkwitz-Riley crossovers split the input, every band runs its own
+// LifterEngine, and the bands are summed back into the host buffer.
+//
+// The split is a tree of 4th order LR crossovers, lowest first. Each band below a crossover
+// also goes through that crossover's allpass, so all bands share the same phase response
+// and their sum is an allpass of the input: with every band at unity the output is flat.
+//
+// Splitting, band processing and summing run stage by stage over chunks that fit the band
+// buffers allocated in prepare. In realtime a chunk is one processor sub-block, so it stays
+// in cache. Offline a chunk is up to a whole host block, and the bands of a long chunk
+// are processed in parallel on the shared WorkerPool.
+class MultibandLifter
+{
+public:
+    static constexpr int maxBands = 6;
+
+    // Offline chunks shorter than this are not worth handing to the pool
+    static constexpr int parallelThreshold = 2048;
+
+    MultibandLifter() = default;
+
+    // spec.maximumBlockSize is the longest offline chunk, realtimeChunkSize the realtime one.
+    // Band buffers are only allocated for the precision the host will use.
+    void prepare (const juce::dsp::ProcessSpec& spec, int realtimeChunkSize, bool doublePrecision);
+    void reset();
+
+    void setNumBands (int newNumBands) noexcept { numBands = juce::jlimit (1, maxBands, newNumBands); }
+    int getNumBands() const noexcept { return numBands; }
+
+    // Crossover index 0 is the lowest. Frequencies are kept ascending and below Nyquist.
+    void setCrossover (int index, float frequencyHz);
+
+    // Offline, process() may block while the worker pool runs the bands
+    void setNonRealtime (bool isNonRealtime) noexcept { nonRealtime = isNonRealtime; }
+
+    LifterEngine& getBand (int band) noexcept { return bands[(size_t) band]; }
+
+    template <typename Callback>
+    void forEachBand (Callback&& callback)
+    {
+        for (auto& band : bands)
+            callback (band);
+    }
+
+    template <typename SampleType>
+    void process (juce::AudioBuffer<SampleType>& buffer);
+
+    // Once every band has settled on silence: split and sum, with each band scaled by the
+    // gain it last applied instead of running its Lifter
+    template <typename SampleType>
+    void processHeld (juce::AudioBuffer<SampleType>& buffer);
+
+    // Gain addition of the band adding the most, in dB
+    float getGainAddition() const noexcept;
+
+    // Sum of the bands' gain additions, in dB. It moves whenever any band does.
+    float getTotalGainAddition() const noexcept;
+
+private:
+    template <typename SampleType>
+    void processChunks (juce::AudioBuffer<SampleType>& buffer, bool holdGains);
+    template <typename SampleType>
+    void split (const juce::AudioBuffer<SampleType>& buffer, int start, int length);
+    template <typename SampleType>
+    void processBands (int length);
+    template <typename SampleType>
+    void processBand (int band, int length);
+    template <typename SampleType>
+    void applyHeldGains (int length);
+    template <typename SampleType>
+    void sum (juce::AudioBuffer<SampleType>& buffer, int start, int length);
+
+    template <typename SampleType>
+    std::array<juce::AudioBuffer<SampleType>, maxBands>& getBandBuffers() noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+            return floatBands;
+        else
+            return doubleBands;
+    }
+
+    void updateCrossovers();
+
+    std::array<LifterEngine, maxBands> bands;
+
+    // Filters run in double for both precisions, which keeps low crossovers clean
+    using Filter = juce::dsp::LinkwitzRileyFilter<double>;
+    std::array<Filter, maxBands - 1> splitters;
+    std::array<std::array<Filter, maxBands - 1>, maxBands> allpasses; // [band][crossover]
+    std::array<float, maxBands - 1> crossoverHz { 120.0f, 500.0f, 2000.0f, 5000.0f, 10000.0f };
+
+    std::array<juce::AudioBuffer<float>, maxBands> floatBands;
+    std::array<juce::AudioBuffer<double>, maxBands> doubleBands;
+
+    double sampleRate = 44100.0;
+    int numBands = 1;
+    int numChannels = 0;
+    int capacity = 0;
+    int realtimeChunk = 128;
+    bool nonRealtime = false;
+
+    // Length of the chunk the pool is working on
+    int pendingLength = 0;
+    juce::SharedResourcePointer<WorkerPool> workerPool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultibandLifter)
+};
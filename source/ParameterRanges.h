@@ -0,0 +1,22 @@
+#pragma once
+
+// Ranges and defaults of the Lifter's DSP parameters. Both the plugin's Parameters namespace
+// and the LifterDSP library read them from here, so there is one copy. Kept free of JUCE and
+// of anything else plugin-side, since the library includes it too.
+namespace ParameterRanges
+{
+    struct Range
+    {
+        float min, max, defaultValue;
+    };
+
+    constexpr Range ratio   { 1.0f, 100.0f, 4.0f };
+    constexpr Range thres   { -90.0f, 0.0f, -40.0f };
+    constexpr Range knee    { 1.0f, 30.0f, 12.0f };
+    constexpr Range attack  { 0.1f, 250.0f, 15.0f };
+    constexpr Range release { 5.0f, 3000.0f, 60.0f };
+    constexpr Range makeup  { -30.0f, 30.0f, 0.0f };
+    constexpr Range mix     { 0.0f, 100.0f, 100.0f };
+
+    constexpr bool feedForwardDefault = true;
+}
@@ -4,8 +4,8 @@ PluginEditor::PluginEditor (LifterProcessor& p)
     : AudioProcessorEditor (&p),
       processorRef (p)
 {
-    juce::ignoreUnused (processorRef);
-    juce::LookAndFeel::setDefaultLookAndFeel(&myCustomLnF);
+    // Set on the editor rather than as the default, so other editors and plugins are left alone
+    setLookAndFeel(&resources->lookAndFeel);
     
     // --- LAYOUT ---
     header.setColour (juce::TextButton::buttonColourId, punk_dsp::UIConstants::background.brighter(0.5f)
@@ -21,75 +21,14 @@ PluginEditor::PluginEditor (LifterProcessor& p)
     params.setEnabled(false);
     addAndMakeVisible (params);
     
-    // Ratio knob
-    ratioSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
-    ratioSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
-    ratioSlider.setRange(Parameters::ratioMin, Parameters::ratioMax, 0.1);
-    ratioSlider.setValue(Parameters::ratioDefault);
-    ratioSlider.setName("Ratio");
-    addAndMakeVisible(ratioSlider);
-    
-    ratioAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(processorRef.apvts, Parameters::ratioId, ratioSlider);
-    
-    // Thres knob
-    thresSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
-    thresSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
-    thresSlider.setRange(Parameters::thresMin, Parameters::thresMax, 0.1);
-    thresSlider.setValue(Parameters::thresDefault);
-    thresSlider.setName("Thres");
-    addAndMakeVisible(thresSlider);
-    
-    thresAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(processorRef.apvts, Parameters::thresId, thresSlider);
-    
-    // Knee knob
-    kneeSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
-    kneeSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
-    kneeSlider.setRange(Parameters::kneeMin, Parameters::kneeMax, 0.1);
-    kneeSlider.setValue(Parameters::kneeDefault);
-    kneeSlider.setName("Knee");
-    addAndMakeVisible(kneeSlider);
-    
-    kneeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(processorRef.apvts, Parameters::kneeId, kneeSlider);
-
-    // Attack knob
-    attackSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
-    attackSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
-    attackSlider.setRange(Parameters::attackMin, Parameters::attackMax, 0.1);
-    attackSlider.setValue(Parameters::attackDefault);
-    attackSlider.setName("Att");
-    addAndMakeVisible(attackSlider);
-    
-    attackAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(processorRef.apvts, Parameters::attackId, attackSlider);
-
-    // Release knob
-    releaseSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
-    releaseSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
-    releaseSlider.setRange(Parameters::releaseMin, Parameters::releaseMax, 0.1);
-    releaseSlider.setValue(Parameters::releaseDefault);
-    releaseSlider.setName("Rel");
-    addAndMakeVisible(releaseSlider);
-    
-    releaseAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(processorRef.apvts, Parameters::releaseId, releaseSlider);
-
-    // Makeup knob
-    makeupSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
-    makeupSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
-    makeupSlider.setRange(Parameters::makeupMin, Parameters::makeupMax, 0.1);
-    makeupSlider.setValue(Parameters::makeupDefault);
-    makeupSlider.setName("Makeup");
-    addAndMakeVisible(makeupSlider);
-    
-    makeupAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(processorRef.apvts, Parameters::makeupId, makeupSlider);
-    
-    // Mix knob
-    mixSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
-    mixSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
-    mixSlider.setRange(Parameters::mixMin, Parameters::mixMax, 0.01);
-    mixSlider.setValue(Parameters::mixDefault);
-    mixSlider.setName("Mix");
-    addAndMakeVisible(mixSlider);
-    
-    mixAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(processorRef.apvts, Parameters::mixId, mixSlider);
+    // Knobs. The attachments take range, step and value from the parameters.
+    setupKnob (ratioSlider, ratioAttachment, Parameters::ratioId, "Ratio");
+    setupKnob (thresSlider, thresAttachment, Parameters::thresId, "Thres");
+    setupKnob (kneeSlider, kneeAttachment, Parameters::kneeId, "Knee");
+    setupKnob (attackSlider, attackAttachment, Parameters::attackId, "Att");
+    setupKnob (releaseSlider, releaseAttachment, Parameters::releaseId, "Rel");
+    setupKnob (makeupSlider, makeupAttachment, Parameters::makeupId, "Makeup");
+    setupKnob (mixSlider, mixAttachment, Parameters::mixId, "Mix");
 
     // Topology button
     feedButton.setClickingTogglesState(true);
@@ -100,24 +39,63 @@ PluginEditor::PluginEditor (LifterProcessor& p)
     feedAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(processorRef.apvts, Parameters::feedId, feedButton);
     
     // Gain Reduction Display
-    gaDisplay.setClickingTogglesState(false);
     addAndMakeVisible(gaDisplay);
-    gaDisplay.setButtonText ("GA: 0.0 dB");
-    startTimer(50);
+    
+    // Snapshot selectors (A/B)
+    for (size_t i = 0; i < snapshotButtons.size(); ++i)
+    {
+        auto& button = snapshotButtons[i];
+        button.setButtonText (juce::String::charToString ((juce::juce_wchar) ('A' + i)));
+        button.setClickingTogglesState(true);
+        button.setRadioGroupId(1);
+        button.setToggleState((int) i == processorRef.getActiveSnapshot(), juce::dontSendNotification);
+        button.onClick = [this, i]() { if (snapshotButtons[i].getToggleState()) processorRef.switchSnapshot ((int) i); };
+        addAndMakeVisible(button);
+    }
+    
+    // Gain trace
+    traceButton.setButtonText ("Trace");
+    traceButton.setClickingTogglesState(true);
+    traceButton.setToggleState(processorRef.isRecordingGainTrace(), juce::dontSendNotification);
+    traceButton.onClick = [this]() { toggleGainTrace(); };
+    addAndMakeVisible(traceButton);
+    
+    // Gain Addition History
+    addAndMakeVisible(gaHistory);
+    processorRef.setMeteringActive(true);
+    
+    // Transfer curve, next to the history
+    addAndMakeVisible(transferCurve);
+    
+   #if LIFTER_PROFILING
+    setWantsKeyboardFocus(true);
+   #endif
     
     // Sizing calculations
     const int numCols = 3;
     const int numRows = 3;
     
     const int totalWidth = (numCols * (punk_dsp::UIConstants::knobSize + 2 * punk_dsp::UIConstants::margin)) + (10 * 2);
-    const int totalHeight = punk_dsp::UIConstants::headerHeight + (numRows * (punk_dsp::UIConstants::knobSize + 2 * punk_dsp::UIConstants::margin)) + (10 * 2);
+    const int totalHeight = punk_dsp::UIConstants::headerHeight + (numRows * (punk_dsp::UIConstants::knobSize + 2 * punk_dsp::UIConstants::margin)) + (10 * 2) + historyHeight;
     
     setSize (totalWidth, totalHeight);
 }
 
 PluginEditor::~PluginEditor()
 {
-    juce::LookAndFeel::setDefaultLookAndFeel(nullptr);
+    processorRef.setMeteringActive(false);
+    setLookAndFeel(nullptr);
+}
+
+void PluginEditor::setupKnob (juce::Slider& slider, std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>& attachment,
+                              const char* parameterId, const juce::String& label)
+{
+    slider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
+    slider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    slider.setName(label);
+    addAndMakeVisible(slider);
+    
+    attachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(processorRef.apvts, parameterId, slider);
 }
 
 void PluginEditor::paint (juce::Graphics& g)
@@ -126,12 +104,108 @@ void PluginEditor::paint (juce::Graphics& g)
     g.fillAll (punk_dsp::UIConstants::background);
 }
 
-void PluginEditor::timerCallback()
+void PluginEditor::updateDisplays()
 {
     float gaValue = processorRef.sendGainAddition();
-    gaDisplay.setButtonText ("GA: " + juce::String (gaValue, 1) + " dB");
+    
+    // Show the largest gain addition since the last tick instead of a single snapshot
+    const auto numFrames = processorRef.meterFifo.drain ([this, &gaValue, first = true] (const MeterFrame& frame) mutable
+    {
+        gaHistory.pushFrame (frame);
+        
+        if (first || std::abs (frame.gainAddition) > std::abs (gaValue))
+            gaValue = frame.gainAddition;
+        first = false;
+    });
+    
+    gaDisplay.setGainAddition (gaValue);
+    
+    auto value = [this] (const char* id) { return processorRef.apvts.getRawParameterValue (id)->load(); };
+    
+    // Draw the curves of the DSP that runs: the bands' own settings in multiband, the global ones otherwise
+    static_assert (Parameters::maxBands <= TransferCurve::maxCurves);
+    TransferCurve::State curveState;
+    curveState.numCurves = Parameters::getNumBands (juce::roundToInt (value (Parameters::bandsId)));
+    curveState.resolution = static_cast<GainCurve::Resolution> (juce::roundToInt (value (Parameters::curveId)));
+    curveState.mix = value (Parameters::mixId) / 100.0f;
+    curveState.usesEngine = curveState.numCurves > 1 || processorRef.isUsingEngine();
+    
+    if (curveState.numCurves > 1)
+    {
+        for (size_t band = 0; band < (size_t) curveState.numCurves; ++band)
+        {
+            auto bandValue = [&] (Parameters::BandIndex index)
+            {
+                return value (Parameters::ids[Parameters::firstBand + band * Parameters::numBandParams + static_cast<size_t> (index)]);
+            };
+            
+            curveState.curves[band] = { bandValue (Parameters::BandIndex::thres), bandValue (Parameters::BandIndex::ratio),
+                                        bandValue (Parameters::BandIndex::knee), bandValue (Parameters::BandIndex::makeup) };
+        }
+    }
+    else
+    {
+        curveState.curves[0] = { value (Parameters::thresId), value (Parameters::ratioId), value (Parameters::kneeId), value (Parameters::makeupId) };
+    }
+    
+    transferCurve.setState (curveState);
+    
+    // The active snapshot can also change when the host loads a state
+    auto& activeButton = snapshotButtons[(size_t) processorRef.getActiveSnapshot()];
+    if (! activeButton.getToggleState())
+        activeButton.setToggleState(true, juce::dontSendNotification);
+    
+    if (traceButton.getToggleState() != processorRef.isRecordingGainTrace())
+        traceButton.setToggleState(processorRef.isRecordingGainTrace(), juce::dontSendNotification);
+    
+    if (numFrames > 0)
+        gaHistory.repaint();
+    
+   #if LIFTER_PROFILING
+    if (profilerOverlay != nullptr && profilerOverlay->isVisible())
+        profilerOverlay->update();
+   #endif
 }
 
+void PluginEditor::toggleGainTrace()
+{
+    if (! traceButton.getToggleState())
+    {
+        processorRef.stopGainTrace();
+        return;
+    }
+    
+    auto folder = juce::File::getSpecialLocation (juce::File::userDocumentsDirectory).getChildFile ("Lifter Traces");
+    folder.createDirectory();
+    
+    const auto name = "Lifter " + juce::Time::getCurrentTime().formatted ("%Y-%m-%d %H-%M-%S");
+    
+    if (! processorRef.startGainTrace (folder.getNonexistentChildFile (name, ".lftt", false)))
+        traceButton.setToggleState(false, juce::dontSendNotification);
+}
+
+#if LIFTER_PROFILING
+bool PluginEditor::keyPressed (const juce::KeyPress& key)
+{
+    if (key == juce::KeyPress ('p', juce::ModifierKeys::commandModifier | juce::ModifierKeys::shiftModifier, 0))
+    {
+        // Built on first use, most sessions never open it
+        if (profilerOverlay == nullptr)
+        {
+            profilerOverlay = std::make_unique<ProfilerOverlay> (processorRef);
+            profilerOverlay->setBounds (gaHistory.getBounds());
+            addChildComponent (*profilerOverlay);
+        }
+        
+        profilerOverlay->setVisible (! profilerOverlay->isVisible());
+        profilerOverlay->toFront (false);
+        return true;
+    }
+    
+    return false;
+}
+#endif
+
 void PluginEditor::resized()
 {
     // layout the positions of your child components here
@@ -139,10 +213,23 @@ void PluginEditor::resized()
     
     // --- LAYOUT SETUP ---
     auto headerArea = area.removeFromTop( 30 );
+    auto historyArea = area.removeFromBottom( historyHeight ).reduced( 10, 0 ).withTrimmedBottom( 10 );
     auto paramsArea = area.reduced( 10 );
     
     header.setBounds(headerArea);
+    
+    auto snapshotArea = headerArea.reduced( 4 );
+    for (auto it = snapshotButtons.rbegin(); it != snapshotButtons.rend(); ++it)
+        it->setBounds(snapshotArea.removeFromRight( snapshotArea.getHeight() ).reduced( 1, 0 ));
+    traceButton.setBounds(snapshotArea.removeFromRight( 2 * snapshotArea.getHeight() ).reduced( 1, 0 ).withTrimmedRight( 4 ));
     params.setBounds(paramsArea);
+    transferCurve.setBounds(historyArea.removeFromLeft( historyArea.getHeight() ));
+    gaHistory.setBounds(historyArea.withTrimmedLeft( 6 ));
+    
+   #if LIFTER_PROFILING
+    if (profilerOverlay != nullptr)
+        profilerOverlay->setBounds(gaHistory.getBounds());
+   #endif
     
     // --- PARAMS LAYOUT ---
     juce::FlexBox fb;
@@ -1,9 +1,14 @@
 #pragma once
 
 #include "PluginProcessor.h"
+#include "GainHistory.h"
+#include "GainMeter.h"
+#include "TransferCurve.h"
+#include "ProfilerOverlay.h"
+#include "EditorResources.h"
 
 //==============================================================================
-class PluginEditor : public juce::AudioProcessorEditor, private juce::Timer
+class PluginEditor : public juce::AudioProcessorEditor
 {
 public:
     explicit PluginEditor (LifterProcessor&);
@@ -14,13 +19,20 @@ public:
     void resized() override;
 
 private:
-    void timerCallback() override;
+    // Once per display refresh. Nothing repaints unless what it shows has changed.
+    void updateDisplays();
+    void setupKnob (juce::Slider& slider, std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>& attachment,
+                    const char* parameterId, const juce::String& label);
+    
+   #if LIFTER_PROFILING
+    bool keyPressed (const juce::KeyPress&) override;
+   #endif
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     LifterProcessor& processorRef;
     
-    // Custom Look and Feel
-    punk_dsp::ExamplesLnF myCustomLnF;
+    // Custom Look and Feel, one for all editors
+    juce::SharedResourcePointer<EditorResources> resources;
     
     // Layout utilities
     juce::TextButton header, params;
@@ -29,7 +41,21 @@ private:
     juce::Slider ratioSlider, thresSlider, kneeSlider, attackSlider, releaseSlider, makeupSlider, mixSlider;
     
     juce::TextButton feedButton;
-    juce::TextButton gaDisplay;
+    GainMeter gaDisplay;
+    GainHistory gaHistory;
+    TransferCurve transferCurve;
+    static constexpr int historyHeight = 80;
+    
+    // A/B snapshot selectors, in the header
+    std::array<juce::TextButton, Parameters::numSnapshots> snapshotButtons;
+    
+    // Gain trace recording, next to the snapshots. Files go to Documents/Lifter Traces.
+    juce::TextButton traceButton;
+    void toggleGainTrace();
+    
+   #if LIFTER_PROFILING
+    std::unique_ptr<ProfilerOverlay> profilerOverlay;
+   #endif
     
     // Attachments for linking sliders-parameters
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> ratioAttachment, thresAttachment, kneeAttachment, attackAttachment, releaseAttachment, makeupAttachment, mixAttachment;
@@ -45,5 +71,8 @@ private:
             feedButton.setButtonText("Feed-Back");
     }
     
+    // Last, so it only starts calling back once everything above exists
+    juce::VBlankAttachment vblank { this, [this] { updateDisplays(); } };
+    
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginEditor)
 };
@@ -1,5 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "PluginState.h"
 
 //==============================================================================
 LifterProcessor::LifterProcessor()
@@ -12,10 +13,23 @@ LifterProcessor::LifterProcessor()
 #endif
                   ), apvts(*this, nullptr, "Parameters", createParams())
 {
+    for (size_t i = 0; i < Parameters::count; ++i)
+    {
+        rawParams[i] = apvts.getRawParameterValue (Parameters::ids[i]);
+        parameters[i] = apvts.getParameter (Parameters::ids[i]);
+        apvts.addParameterListener (Parameters::ids[i], this);
+        
+        // Same ids the CLAP wrapper derives from the JUCE parameter ids
+        clapParamIds[i] = (clap_id) juce::String (Parameters::ids[i]).hashCode();
+    }
+    
+    snapshots.fill (getCurrentValues());
 }
 
 LifterProcessor::~LifterProcessor()
 {
+    for (auto* id : Parameters::ids)
+        apvts.removeParameterListener (id, this);
 }
 
 //==============================================================================
@@ -53,7 +67,20 @@ bool LifterProcessor::isMidiEffect() const
 
 double LifterProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // How long the gain keeps moving after the input changes, set by the release time.
+    // In multiband each band releases on its own, so the slowest one sets the tail.
+    const auto numBands = Parameters::getNumBands (juce::roundToInt (rawParams[(size_t) Parameters::Index::bands]->load()));
+    auto releaseMs = rawParams[(size_t) Parameters::Index::release]->load();
+    
+    if (numBands > 1)
+    {
+        releaseMs = 0.0f;
+        
+        for (size_t band = 0; band < (size_t) numBands; ++band)
+            releaseMs = juce::jmax (releaseMs, rawParams[Parameters::firstBand + band * Parameters::numBandParams + (size_t) Parameters::BandIndex::release]->load());
+    }
+    
+    return releaseMs * 0.001 * Parameters::settleTimeConstants;
 }
 
 int LifterProcessor::getNumPrograms()
@@ -86,109 +113,276 @@ void LifterProcessor::changeProgramName (int index, const juce::String& newName)
 // =========== PARAMETER LAYOUT ====================
 juce::AudioProcessorValueTreeState::ParameterLayout LifterProcessor::createParams()
 {
-    juce::AudioProcessorValueTreeState::ParameterLayout layout;
-    
-    // Ratio (:1)
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-                                                           Parameters::ratioId,
-                                                           Parameters::ratioName,
-                                                           juce::NormalisableRange<float>(Parameters::ratioMin, Parameters::ratioMax, 0.1f),
-                                                           Parameters::ratioDefault
-                                                           )
-               );
-    
-    // Threshold (dB)
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-                                                           Parameters::thresId,
-                                                           Parameters::thresName,
-                                                           juce::NormalisableRange<float>(Parameters::thresMin, Parameters::thresMax, 0.1f),
-                                                           Parameters::thresDefault
-                                                           )
-               );
-    
-    // Knee Width (dB)
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-                                                           Parameters::kneeId,
-                                                           Parameters::kneeName,
-                                                           juce::NormalisableRange<float>(Parameters::kneeMin, Parameters::kneeMax, 0.1f),
-                                                           Parameters::kneeDefault
-                                                           )
-               );
-    
-    // Attack Time (ms)
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-                                                           Parameters::attackId,
-                                                           Parameters::attackName,
-                                                           juce::NormalisableRange<float>(Parameters::attackMin, Parameters::attackMax, 0.1f),
-                                                           Parameters::attackDefault
-                                                           )
-               );
-    
-    // Release Time (ms)
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-                                                           Parameters::releaseId,
-                                                           Parameters::releaseName,
-                                                           juce::NormalisableRange<float>(Parameters::releaseMin, Parameters::releaseMax, 0.1f),
-                                                           Parameters::releaseDefault
-                                                           )
-               );
-    
-    // Make-up Gain (dB)
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-                                                           Parameters::makeupId,
-                                                           Parameters::makeupName,
-                                                           juce::NormalisableRange<float>(Parameters::makeupMin, Parameters::makeupMax, 0.1f),
-                                                           Parameters::makeupDefault
-                                                           )
-               );
-    
-    // Topology (feedforward / feedback)
-    layout.add(std::make_unique<juce::AudioParameterBool>(
-                                                          Parameters::feedId,
-                                                          Parameters::feedName,
-                                                          Parameters::feedDefault
-                                                          )
-               );
-    
-    // Mix (%)
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-                                                           Parameters::mixId,
-                                                           Parameters::mixName,
-                                                           juce::NormalisableRange<float>(Parameters::mixMin, Parameters::mixMax, 1.0f),
-                                                           Parameters::mixDefault
-                                                           )
-               );
+    std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
+    params.reserve (Parameters::count);
+    
+    for (const auto& d : Parameters::descriptors)
+    {
+        const auto name = d.band > 0 ? "Band " + juce::String (d.band) + " " + d.name : juce::String (d.name);
         
-    return layout;
+        switch (d.kind)
+        {
+            case Parameters::Kind::continuous:
+            {
+                juce::NormalisableRange<float> range (d.min, d.max, d.step);
+                if (d.skewCentre > 0.0f)
+                    range.setSkewForCentre (d.skewCentre);
+                
+                params.push_back (std::make_unique<juce::AudioParameterFloat> (d.id, name, range, d.defaultValue));
+                break;
+            }
+            
+            case Parameters::Kind::toggle:
+                params.push_back (std::make_unique<juce::AudioParameterBool> (d.id, name, d.defaultValue >= 0.5f));
+                break;
+                
+            case Parameters::Kind::choice:
+                params.push_back (std::make_unique<juce::AudioParameterChoice> (d.id, name, *d.choices, (int) d.defaultValue));
+                break;
+        }
+    }
+    
+    return { params.begin(), params.end() };
 }
 
 //==============================================================================
-void LifterProcessor::updateParameters()
+void LifterProcessor::parameterChanged (const juce::String& parameterID, float newValue)
 {
-    lifter.updateRatio( apvts.getRawParameterValue(Parameters::ratioId)->load() );
-    lifter.updateRange( apvts.getRawParameterValue(Parameters::thresId)->load() );
-    lifter.updateKnee( apvts.getRawParameterValue(Parameters::kneeId)->load() );
+    juce::ignoreUnused (newValue);
     
-    lifter.updateAttack( apvts.getRawParameterValue(Parameters::attackId)->load() );
-    lifter.updateRelease( apvts.getRawParameterValue(Parameters::releaseId)->load() );
+    // Can be called from any thread, so only raise flags here
+    for (size_t i = 0; i < Parameters::count; ++i)
+    {
+        if (parameterID == Parameters::ids[i])
+        {
+            dirtyParams[i].store (true, std::memory_order_relaxed);
+            anyParamDirty.store (true, std::memory_order_release);
+            return;
+        }
+    }
+}
+
+void LifterProcessor::pushParameter (Parameters::Index index, float value)
+{
+    // The detector has a new target, so it has to run until it settles again
+    settled = false;
     
-    lifter.updateMakeUp( apvts.getRawParameterValue(Parameters::makeupId)->load() );
+    // Both Lifters get every change, so switching between them never picks up stale settings
+    switch (index)
+    {
+        case Parameters::Index::ratio:   lifter.updateRatio (value); engine.updateRatio (value); break;
+        case Parameters::Index::thres:   thresSmoothed.setTargetValue (value); engine.updateRange (value); break;
+        case Parameters::Index::knee:    lifter.updateKnee (value); engine.updateKnee (value); break;
+        case Parameters::Index::attack:  lifter.updateAttack (value); engine.updateAttack (value); break;
+        case Parameters::Index::release: lifter.updateRelease (value); engine.updateRelease (value); break;
+        case Parameters::Index::makeup:  makeupSmoothed.setTargetValue (value); engine.updateMakeUp (value); break;
+        case Parameters::Index::feed:
+            lifter.updateFeedForward (value >= 0.5f);
+            engine.updateFeedForward (value >= 0.5f);
+            multiband.forEachBand ([value] (LifterEngine& band) { band.updateFeedForward (value >= 0.5f); });
+            break;
+            
+        case Parameters::Index::mix:
+            mixSmoothed.setTargetValue (value);
+            break;
+        
+        case Parameters::Index::curve:
+            curveResolution = static_cast<GainCurve::Resolution> (juce::roundToInt (value));
+            engine.setCurveResolution (curveResolution);
+            multiband.forEachBand ([this] (LifterEngine& band) { band.setCurveResolution (curveResolution); });
+            updateEngineSelection();
+            break;
+            
+        case Parameters::Index::link:
+            linkMode = static_cast<LifterEngine::Link> (juce::roundToInt (value));
+            engine.setLink (linkMode);
+            multiband.forEachBand ([this] (LifterEngine& band) { band.setLink (linkMode); });
+            updateEngineSelection();
+            break;
+            
+        case Parameters::Index::eco:
+            ecoInterval = Parameters::getEcoInterval (juce::roundToInt (value));
+            engine.setControlInterval (ecoInterval);
+            multiband.forEachBand ([this] (LifterEngine& band) { band.setControlInterval (ecoInterval); });
+            updateEngineSelection();
+            break;
+            
+        case Parameters::Index::truePeak:
+            truePeakFactor = Parameters::getTruePeakFactor (juce::roundToInt (value));
+            engine.setTruePeakFactor (truePeakFactor);
+            multiband.forEachBand ([this] (LifterEngine& band) { band.setTruePeakFactor (truePeakFactor); });
+            updateEngineSelection();
+            break;
+            
+        case Parameters::Index::bands:
+            // Bands come back in from a clean state rather than whatever they held when last used
+            if (Parameters::getNumBands (juce::roundToInt (value)) != multiband.getNumBands())
+            {
+                multiband.reset();
+                
+                // Ramps of bands that were not running start at their targets
+                for (auto* smoothers : { &bandThresSmoothed, &bandMakeupSmoothed })
+                    for (auto& smoothed : *smoothers)
+                        smoothed.setCurrentAndTargetValue (smoothed.getTargetValue());
+            }
+            multiband.setNumBands (Parameters::getNumBands (juce::roundToInt (value)));
+            break;
+            
+        case Parameters::Index::xover1:
+        case Parameters::Index::xover2:
+        case Parameters::Index::xover3:
+        case Parameters::Index::xover4:
+        case Parameters::Index::xover5:
+            multiband.setCrossover ((int) index - (int) Parameters::Index::xover1, value);
+            break;
+            
+        case Parameters::Index::firstBand:
+        default:
+        {
+            const auto bandParam = (size_t) index - Parameters::firstBand;
+            pushBandParameter ((int) (bandParam / Parameters::numBandParams),
+                               static_cast<Parameters::BandIndex> (bandParam % Parameters::numBandParams),
+                               value);
+            break;
+        }
+    }
+}
+
+void LifterProcessor::pushBandParameter (int band, Parameters::BandIndex index, float value)
+{
+    auto& lifterBand = multiband.getBand (band);
     
-    lifter.updateFeedForward ( (bool) apvts.getRawParameterValue(Parameters::feedId)->load() );
+    switch (index)
+    {
+        case Parameters::BandIndex::ratio:   lifterBand.updateRatio (value); break;
+        case Parameters::BandIndex::thres:   bandThresSmoothed[(size_t) band].setTargetValue (value); lifterBand.updateRange (value); break;
+        case Parameters::BandIndex::knee:    lifterBand.updateKnee (value); break;
+        case Parameters::BandIndex::attack:  lifterBand.updateAttack (value); break;
+        case Parameters::BandIndex::release: lifterBand.updateRelease (value); break;
+        case Parameters::BandIndex::makeup:  bandMakeupSmoothed[(size_t) band].setTargetValue (value); lifterBand.updateMakeUp (value); break;
+        case Parameters::BandIndex::count:   break;
+    }
+}
+
+void LifterProcessor::setNonRealtime (bool isNonRealtime) noexcept
+{
+    AudioProcessor::setNonRealtime (isNonRealtime);
+    multiband.setNonRealtime (isNonRealtime);
+    gainTrace.setNonRealtime (isNonRealtime);
+}
+
+void LifterProcessor::setSubBlockSize (int newSize)
+{
+    requestedSubBlockSize.store (juce::jlimit (Parameters::subBlockMin, Parameters::subBlockMax, newSize));
+}
+
+void LifterProcessor::updateEngineSelection()
+{
+    // punk_dsp::Lifter covers the plain mono/stereo case, everything else needs the engine
+    const auto shouldUseEngine = curveResolution != GainCurve::Resolution::exact
+                              || linkMode != LifterEngine::Link::perChannel
+                              || ecoInterval > 1
+                              || truePeakFactor > 1
+                              || getTotalNumOutputChannels() > 2;
+    
+    // Start the engine from a clean state rather than whatever it held when last used
+    if (shouldUseEngine && ! useEngine)
+        engine.reset();
     
-    lifter.updateMix( apvts.getRawParameterValue(Parameters::mixId)->load() );
+    useEngine = shouldUseEngine;
+}
+
+void LifterProcessor::updateParameters()
+{
+    // A recalled snapshot lands in full, before any flags raised by syncing the parameters to it
+    if (recalledValues.update())
+    {
+        const auto& values = recalledValues.getReadBuffer();
+        
+        for (size_t i = 0; i < Parameters::count; ++i)
+            pushParameter (static_cast<Parameters::Index> (i), values[i]);
+    }
+    
+    // Nothing has moved since the last block
+    if (! anyParamDirty.exchange (false, std::memory_order_acquire))
+        return;
+    
+    for (size_t i = 0; i < Parameters::count; ++i)
+        if (dirtyParams[i].exchange (false, std::memory_order_relaxed))
+            pushParameter (static_cast<Parameters::Index> (i), rawParams[i]->load());
 }
 
 void LifterProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
+    // Hosts may send more than samplesPerBlock, but processBlock never passes on more than a sub-block
+    subBlockSize = requestedSubBlockSize.load();
+    
     juce::dsp::ProcessSpec spec;
-    spec.maximumBlockSize = samplesPerBlock;
+    spec.maximumBlockSize = (juce::uint32) subBlockSize;
     spec.numChannels = getTotalNumOutputChannels();
     spec.sampleRate = sampleRate;
     
     lifter.prepare(spec);
+    floatScratch.setSize ((int) spec.numChannels, subBlockSize);
+    
+    thresSmoothed.reset (sampleRate, Parameters::smoothingSeconds);
+    makeupSmoothed.reset (sampleRate, Parameters::smoothingSeconds);
+    mixSmoothed.reset (sampleRate, Parameters::smoothingSeconds);
+    
+    for (auto* smoothers : { &bandThresSmoothed, &bandMakeupSmoothed })
+        for (auto& smoothed : *smoothers)
+            smoothed.reset (sampleRate, Parameters::smoothingSeconds);
+    
+    // Offline tools call this directly, and the tail length reads the rate back
+    setRateAndBufferSizeDetails (sampleRate, samplesPerBlock);
+    settled = false;
+    lastGainAddition = 0.0f;
+    
+    // Push every parameter once, without ramping from stale values
+    anyParamDirty.store (false);
+    for (size_t i = 0; i < Parameters::count; ++i)
+    {
+        dirtyParams[i].store (false);
+        pushParameter (static_cast<Parameters::Index> (i), rawParams[i]->load());
+    }
+    
+    thresSmoothed.setCurrentAndTargetValue (thresSmoothed.getTargetValue());
+    makeupSmoothed.setCurrentAndTargetValue (makeupSmoothed.getTargetValue());
+    mixSmoothed.setCurrentAndTargetValue (mixSmoothed.getTargetValue());
+    
+    for (auto* smoothers : { &bandThresSmoothed, &bandMakeupSmoothed })
+        for (auto& smoothed : *smoothers)
+            smoothed.setCurrentAndTargetValue (smoothed.getTargetValue());
+    
+    lifter.updateRange (thresSmoothed.getCurrentValue());
+    lifter.updateMakeUp (makeupSmoothed.getCurrentValue());
+    lifter.updateMix (mixSmoothed.getCurrentValue());
+    
+    engine.updateRange (thresSmoothed.getCurrentValue());
+    engine.updateMakeUp (makeupSmoothed.getCurrentValue());
+    engine.updateMix (mixSmoothed.getCurrentValue());
+    multiband.forEachBand ([this] (LifterEngine& band) { band.updateMix (mixSmoothed.getCurrentValue()); });
+    
+    // Last, so the engine builds its curve table from the final settings
+    engine.prepare(spec);
+    
+    // Offline chunks can be as long as the host block, realtime ones stay one sub-block long
+    auto multibandSpec = spec;
+    multibandSpec.maximumBlockSize = (juce::uint32) juce::jmax (samplesPerBlock, subBlockSize);
+    multiband.setNonRealtime (isNonRealtime());
+    multiband.prepare (multibandSpec, subBlockSize, isUsingDoublePrecision());
+    
+    samplesPerFrame = juce::jmax (1, juce::roundToInt (sampleRate / MeterFifo::framesPerSecond));
+    pendingFrame = {};
+    pendingSamples = 0;
+    
+    gainTrace.prepare (subBlockSize);
+    gainTrace.setNonRealtime (isNonRealtime());
     
-    updateParameters();
+   #if LIFTER_PROFILING
+    parameterProfiler.prepare (sampleRate);
+    processProfiler.prepare (sampleRate);
+   #endif
 }
 
 void LifterProcessor::releaseResources()
@@ -203,10 +397,10 @@ bool LifterProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
     juce::ignoreUnused (layouts);
     return true;
 #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout, named or discrete, up to maxChannels
+    const auto numChannels = layouts.getMainOutputChannelSet().size();
+    
+    if (numChannels < 1 || numChannels > Parameters::maxChannels)
         return false;
     
     // This checks if the input layout matches the output layout
@@ -223,7 +417,19 @@ void LifterProcessor::processBlock (juce::AudioBuffer<float>& buffer,
                                      juce::MidiBuffer& midiMessages)
 {
     juce::ignoreUnused (midiMessages);
-    
+    processBlockImpl (buffer);
+}
+
+void LifterProcessor::processBlock (juce::AudioBuffer<double>& buffer,
+                                     juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused (midiMessages);
+    processBlockImpl (buffer);
+}
+
+template <typename SampleType>
+void LifterProcessor::processBlockImpl (juce::AudioBuffer<SampleType>& buffer)
+{
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -233,11 +439,385 @@ void LifterProcessor::processBlock (juce::AudioBuffer<float>& buffer,
         buffer.clear (i, 0, buffer.getNumSamples());
     
     // Update params
-    updateParameters();
+    {
+        LIFTER_PROFILE_BLOCK (parameterProfiler, buffer.getNumSamples());
+        updateParameters();
+    }
+    
+    LIFTER_PROFILE_BLOCK (processProfiler, buffer.getNumSamples());
+    processRange (juce::dsp::AudioBlock<const SampleType> (buffer), buffer);
+}
+
+namespace
+{
+    // For the stages that only run in place. Channels that already share memory are left alone.
+    template <typename SampleType>
+    void copyInput (const juce::dsp::AudioBlock<const SampleType>& input, juce::AudioBuffer<SampleType>& output)
+    {
+        for (int ch = 0; ch < output.getNumChannels(); ++ch)
+            if (input.getChannelPointer ((size_t) ch) != output.getReadPointer (ch))
+                juce::FloatVectorOperations::copy (output.getWritePointer (ch), input.getChannelPointer ((size_t) ch), output.getNumSamples());
+    }
+
+    // Between float and double, channel by channel
+    template <typename SourceType, typename DestType>
+    void convertSamples (const juce::dsp::AudioBlock<const SourceType>& source, const juce::dsp::AudioBlock<DestType>& dest)
+    {
+        for (size_t ch = 0; ch < dest.getNumChannels(); ++ch)
+        {
+            const auto* in = source.getChannelPointer (ch);
+            auto* out = dest.getChannelPointer (ch);
+            
+            for (size_t i = 0; i < dest.getNumSamples(); ++i)
+                out[i] = (DestType) in[i];
+        }
+    }
+    
+    template <typename SampleType>
+    float getPeak (const juce::dsp::AudioBlock<const SampleType>& block)
+    {
+        const auto range = block.findMinAndMax();
+        return (float) juce::jmax (-range.getStart(), range.getEnd());
+    }
+}
+
+// Everything after the parameter update. The CLAP path runs it once per stretch between parameter events.
+template <typename SampleType>
+void LifterProcessor::processRange (const juce::dsp::AudioBlock<const SampleType>& input, juce::AudioBuffer<SampleType>& output)
+{
+    const auto numSamples = output.getNumSamples();
+    const auto useMultiband = multiband.getNumBands() > 1;
+    GainTraceRecorder::ScopedWriter trace (gainTrace);
+    
+    // Offline, multiband takes a range with no ramp running in one go, so the worker pool gets
+    // long chunks, unless a trace wants a gain reading per sub-block
+    if (useMultiband && isNonRealtime() && ! isSmoothing() && ! trace.isActive())
+    {
+        copyInput (input, output);
+        processMultiband (output);
+        return;
+    }
+    
+    // Process in cache-sized sub-blocks: large host buffers never outgrow the prepared size,
+    // and every stage below finds the sub-block's samples still in L1
+    for (int start = 0; start < numSamples; start += subBlockSize)
+    {
+        const auto length = juce::jmin (subBlockSize, numSamples - start);
+        const auto inputBlock = input.getSubBlock ((size_t) start, (size_t) length);
+        juce::AudioBuffer<SampleType> subBlock (output.getArrayOfWritePointers(), output.getNumChannels(), start, length);
+        
+        if (trace.isActive())
+            trace.captureInput (inputBlock);
+        
+        processSubBlock (inputBlock, subBlock);
+        
+        if (trace.isActive())
+            trace.recordOutput (subBlock, sendGainAddition());
+    }
+}
+
+//==============================================================================
+clap_process_status LifterProcessor::clap_direct_process (const clap_process* process) noexcept
+{
+    juce::ScopedNoDenormals noDenormals;
+    const auto numSamples = (int) process->frames_count;
+    
+    // The wrapper only exposes 32-bit ports, so data32 is all a host will send.
+    // Input and output may be separate buffers. LifterEngine then reads the input where it is and
+    // writes the output, with no copy; punk_dsp::Lifter (the default) and the bands still get the
+    // input copied into the output first. Without an input for every channel, everything runs in
+    // place on a copy, with silence for the missing channels.
+    juce::AudioBuffer<float> buffer;
+    juce::dsp::AudioBlock<const float> input;
+    
+    if (process->audio_outputs_count > 0 && process->audio_outputs[0].data32 != nullptr)
+    {
+        const auto& output = process->audio_outputs[0];
+        const auto* inputPort = process->audio_inputs_count > 0 ? &process->audio_inputs[0] : nullptr;
+        buffer.setDataToReferTo (output.data32, (int) output.channel_count, numSamples);
+        
+        if (inputPort != nullptr && inputPort->data32 != nullptr && inputPort->channel_count >= output.channel_count)
+        {
+            input = juce::dsp::AudioBlock<const float> (inputPort->data32, output.channel_count, (size_t) numSamples);
+        }
+        else
+        {
+            for (juce::uint32 ch = 0; ch < output.channel_count; ++ch)
+            {
+                if (inputPort == nullptr || inputPort->data32 == nullptr || ch >= inputPort->channel_count)
+                    juce::FloatVectorOperations::clear (output.data32[ch], numSamples);
+                else if (inputPort->data32[ch] != output.data32[ch])
+                    juce::FloatVectorOperations::copy (output.data32[ch], inputPort->data32[ch], numSamples);
+            }
+            
+            input = juce::dsp::AudioBlock<const float> (buffer);
+        }
+    }
+    
+    // Editor changes and recalled snapshots still arrive through the dirty flags
+    {
+        LIFTER_PROFILE_BLOCK (parameterProfiler, numSamples);
+        updateParameters();
+    }
+    
+    auto processUpTo = [this, &buffer, &input, position = 0] (int end) mutable
+    {
+        if (end > position && buffer.getNumChannels() > 0)
+        {
+            juce::AudioBuffer<float> range (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), position, end - position);
+            processRange (input.getSubBlock ((size_t) position, (size_t) (end - position)), range);
+        }
+        
+        position = juce::jmax (position, end);
+    };
+    
+    // One profile record for the whole host block, the ranges and the events between them included
+    LIFTER_PROFILE_BLOCK (processProfiler, numSamples);
+    
+    // Events come sorted by time. The block is only split where a parameter actually changes,
+    // so each change lands on its own sample.
+    const auto* events = process->in_events;
+    const auto numEvents = events != nullptr ? events->size (events) : 0u;
+    
+    for (juce::uint32 e = 0; e < numEvents; ++e)
+    {
+        const auto* event = events->get (events, e);
+        
+        if (event == nullptr || event->space_id != CLAP_CORE_EVENT_SPACE_ID || event->type != CLAP_EVENT_PARAM_VALUE)
+            continue;
+        
+        processUpTo (juce::jlimit (0, numSamples, (int) event->time));
+        applyParameterEvent (*reinterpret_cast<const clap_event_param_value*> (event));
+    }
+    
+    processUpTo (numSamples);
+    return CLAP_PROCESS_CONTINUE;
+}
+
+void LifterProcessor::applyParameterEvent (const clap_event_param_value& event)
+{
+    for (size_t i = 0; i < Parameters::count; ++i)
+    {
+        if (clapParamIds[i] != event.param_id)
+            continue;
+        
+        // The wrapper publishes every parameter with a 0 to 1 range
+        auto* parameter = parameters[i];
+        const auto normalised = juce::jlimit (0.0f, 1.0f, (float) event.value);
+        pushParameter (static_cast<Parameters::Index> (i), parameter->convertFrom0to1 (normalised));
+        
+        // Keep the JUCE parameter, and with it the editor and the saved state, in step, as the
+        // wrapper would. The flag this raises pushes the same value again next block, a no-op.
+        if (parameter->getValue() != normalised)
+        {
+            parameter->setValue (normalised);
+            parameter->sendValueChangedMessageToListeners (normalised);
+        }
+        
+        return;
+    }
+}
+
+template <typename SampleType>
+void LifterProcessor::processMultiband (juce::AudioBuffer<SampleType>& buffer)
+{
+    const auto numSamples = buffer.getNumSamples();
+    const auto metering = meteringActive.load (std::memory_order_relaxed);
+    const auto inputPeak = metering ? (float) buffer.getMagnitude (0, numSamples) : 0.0f;
+    
+    multiband.process (buffer);
     
-    // Process
-    lifter.process(buffer);
+    if (metering)
+        pushMeterFrame (inputPeak, (float) buffer.getMagnitude (0, numSamples), numSamples);
+}
+
+template <typename SampleType>
+void LifterProcessor::processSubBlock (const juce::dsp::AudioBlock<const SampleType>& input, juce::AudioBuffer<SampleType>& output)
+{
+    const auto numSamples = output.getNumSamples();
+    const auto metering = meteringActive.load (std::memory_order_relaxed);
+    const auto inputPeak = getPeak (input);
+    const auto smoothing = isSmoothing();
+    
+    const auto silent = inputPeak <= Parameters::silenceFloor;
+    
+    // Silence state: the detector keeps running until it has settled on the silence,
+    // after that the Lifter is skipped and the block just gets the gain it last applied
+    if (! smoothing && silent && settled)
+    {
+        if (multiband.getNumBands() > 1)
+        {
+            // Every band holds its own gain, so the bands are still split and summed
+            copyInput (input, output);
+            multiband.processHeld (output);
+        }
+        else
+        {
+            juce::dsp::AudioBlock<SampleType> (output).replaceWithProductOf (input, (SampleType) heldGain);
+        }
+    }
+    else
+    {
+        if (smoothing)
+            processSmoothed (input, output);
+        else
+            processLifter (input, output);
+        
+        // Settled once a silent sub-block leaves the gain addition where the one before left it.
+        // In multiband that is the sum over the bands, which moves while any band does.
+        const auto gainAddition = multiband.getNumBands() > 1 ? multiband.getTotalGainAddition() : sendGainAddition();
+        settled = silent && std::abs (gainAddition - lastGainAddition) <= Parameters::settleToleranceDb;
+        lastGainAddition = gainAddition;
+        heldGain = getAppliedGain();
+    }
+    
+    if (metering)
+        pushMeterFrame (inputPeak, (float) output.getMagnitude (0, numSamples), numSamples);
+}
+
+bool LifterProcessor::isSmoothing() const noexcept
+{
+    if (thresSmoothed.isSmoothing() || makeupSmoothed.isSmoothing() || mixSmoothed.isSmoothing())
+        return true;
+    
+    // The band ramps only count while the bands run
+    const auto numBands = multiband.getNumBands() > 1 ? (size_t) multiband.getNumBands() : 0;
+    
+    for (size_t b = 0; b < numBands; ++b)
+        if (bandThresSmoothed[b].isSmoothing() || bandMakeupSmoothed[b].isSmoothing())
+            return true;
+    
+    return false;
+}
+
+float LifterProcessor::getAppliedGain()
+{
+    // Same for both Lifters: the gain addition leaves out makeup, and the mix blends with the dry signal
+    const auto wetGain = juce::Decibels::decibelsToGain (sendGainAddition() + makeupSmoothed.getCurrentValue());
+    return 1.0f + mixSmoothed.getCurrentValue() * 0.01f * (wetGain - 1.0f);
+}
+
+void LifterProcessor::pushMeterFrame (float inputPeak, float outputPeak, int numSamples)
+{
+    const auto gainAddition = sendGainAddition();
+    
+    if (std::abs (gainAddition) > std::abs (pendingFrame.gainAddition))
+        pendingFrame.gainAddition = gainAddition;
+    pendingFrame.inputPeak = juce::jmax (pendingFrame.inputPeak, inputPeak);
+    pendingFrame.outputPeak = juce::jmax (pendingFrame.outputPeak, outputPeak);
+    
+    pendingSamples += numSamples;
+    
+    if (pendingSamples >= samplesPerFrame)
+    {
+        meterFifo.push (pendingFrame);
+        pendingFrame = {};
+        pendingSamples = 0;
+    }
+}
+
+template <typename SampleType>
+void LifterProcessor::processSmoothed (const juce::dsp::AudioBlock<const SampleType>& input, juce::AudioBuffer<SampleType>& output)
+{
+    const auto numSamples = output.getNumSamples();
+    const auto numBands = multiband.getNumBands() > 1 ? multiband.getNumBands() : 0;
+    
+    // The Lifter takes one value per call, so the ramps advance in short slices
+    for (int start = 0; start < numSamples; start += Parameters::smoothingStep)
+    {
+        const auto length = juce::jmin (Parameters::smoothingStep, numSamples - start);
+        
+        if (thresSmoothed.isSmoothing())
+        {
+            const auto thres = thresSmoothed.skip (length);
+            lifter.updateRange (thres);
+            engine.rampRange (thres);
+        }
+        if (makeupSmoothed.isSmoothing())
+        {
+            const auto makeup = makeupSmoothed.skip (length);
+            lifter.updateMakeUp (makeup);
+            engine.rampMakeUp (makeup);
+        }
+        if (mixSmoothed.isSmoothing())
+        {
+            const auto mix = mixSmoothed.skip (length);
+            lifter.updateMix (mix);
+            engine.updateMix (mix);
+            multiband.forEachBand ([mix] (LifterEngine& band) { band.updateMix (mix); });
+        }
+        
+        for (int b = 0; b < numBands; ++b)
+        {
+            auto& band = multiband.getBand (b);
+            
+            if (bandThresSmoothed[(size_t) b].isSmoothing())
+                band.rampRange (bandThresSmoothed[(size_t) b].skip (length));
+            if (bandMakeupSmoothed[(size_t) b].isSmoothing())
+                band.rampMakeUp (bandMakeupSmoothed[(size_t) b].skip (length));
+        }
+        
+        // Non-owning views over this slice of the host buffers
+        juce::AudioBuffer<SampleType> slice (output.getArrayOfWritePointers(), output.getNumChannels(), start, length);
+        processLifter (input.getSubBlock ((size_t) start, (size_t) length), slice);
+    }
+}
+
+template <typename SampleType>
+void LifterProcessor::processLifter (const juce::dsp::AudioBlock<const SampleType>& input, juce::AudioBuffer<SampleType>& output)
+{
+    if (multiband.getNumBands() > 1)
+    {
+        // The bands only run in place
+        copyInput (input, output);
+        multiband.process (output);
+        return;
+    }
+    
+    if (! useEngine)
+    {
+        // punk_dsp::Lifter only runs in place, on the float AudioBuffer it is given, and copies the
+        // dry signal itself. It stays the default because it is the reference sound; the engine's
+        // out-of-place path is only taken in the modes that need the engine anyway.
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            copyInput (input, output);
+            lifter.process (output);
+        }
+        else
+        {
+            // Double blocks go through a float copy, so both precisions sound the same
+            jassert (output.getNumSamples() <= floatScratch.getNumSamples());
+            juce::AudioBuffer<float> scratch (floatScratch.getArrayOfWritePointers(), output.getNumChannels(), output.getNumSamples());
+            
+            convertSamples (input, juce::dsp::AudioBlock<float> (scratch));
+            lifter.process (scratch);
+            convertSamples (juce::dsp::AudioBlock<const float> (scratch), juce::dsp::AudioBlock<SampleType> (output));
+        }
+        
+        return;
+    }
+    
+    juce::dsp::AudioBlock<SampleType> block (output);
+    
+    if (input.getChannelPointer (0) == block.getChannelPointer (0))
+        engine.process (juce::dsp::ProcessContextReplacing<SampleType> (block));
+    else
+        engine.process (juce::dsp::ProcessContextNonReplacing<SampleType> (input, block));
+}
+
+#if LIFTER_PROFILING
+BlockProfiler::Stats LifterProcessor::getProfileStats (ProfileStage stage) const noexcept
+{
+    return stage == ProfileStage::parameters ? parameterProfiler.getStats() : processProfiler.getStats();
+}
+
+void LifterProcessor::resetProfile() noexcept
+{
+    parameterProfiler.reset();
+    processProfiler.reset();
 }
+#endif
 
 //==============================================================================
 bool LifterProcessor::hasEditor() const
@@ -254,17 +834,130 @@ juce::AudioProcessorEditor* LifterProcessor::createEditor()
 //==============================================================================
 void LifterProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-    juce::ignoreUnused (destData);
+    // Binary, written straight from the raw values: no ValueTree copy, no XML
+    const auto current = getCurrentValues();
+    
+    // Hosts may save from any thread, while the editor switches snapshots on the message thread
+    const auto [savedSnapshots, savedActive] = getSnapshots();
+    
+    std::array<const float*, 1 + Parameters::numSnapshots> sets { current.data() };
+    for (size_t i = 0; i < savedSnapshots.size(); ++i)
+        sets[i + 1] = savedSnapshots[i].data();
+    
+    PluginState::write (destData, Parameters::ids, sets, savedActive);
 }
 
 void LifterProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
-    juce::ignoreUnused (data, sizeInBytes);
+    auto values = getCurrentValues();
+    auto [loadedSnapshots, loadedActive] = getSnapshots();
+    
+    std::array<float*, 1 + Parameters::numSnapshots> sets { values.data() };
+    for (size_t i = 0; i < loadedSnapshots.size(); ++i)
+        sets[i + 1] = loadedSnapshots[i].data();
+    
+    if (PluginState::read (data, (size_t) sizeInBytes, Parameters::ids, sets, loadedActive))
+    {
+        {
+            const juce::ScopedLock sl (snapshotLock);
+            snapshots = loadedSnapshots;
+            activeSnapshot = juce::jlimit (0, Parameters::numSnapshots - 1, loadedActive);
+        }
+        
+        for (size_t i = 0; i < Parameters::count; ++i)
+            if (auto* parameter = apvts.getParameter (Parameters::ids[i]))
+                parameter->setValueNotifyingHost (parameter->convertTo0to1 (values[i]));
+        
+        return;
+    }
+    
+    // States saved before the binary format
+    auto xml = getXmlFromBinary (data, sizeInBytes);
+    
+    if (xml != nullptr && xml->hasTagName (apvts.state.getType()))
+    {
+        apvts.replaceState (juce::ValueTree::fromXml (*xml));
+        
+        const auto current = getCurrentValues();
+        const juce::ScopedLock sl (snapshotLock);
+        snapshots.fill (current);
+        activeSnapshot = 0;
+    }
+}
+
+//==============================================================================
+Parameters::Values LifterProcessor::getCurrentValues() const
+{
+    Parameters::Values values;
+    
+    for (size_t i = 0; i < Parameters::count; ++i)
+        values[i] = rawParams[i]->load();
+    
+    return values;
+}
+
+std::pair<Parameters::Snapshots, int> LifterProcessor::getSnapshots() const
+{
+    const juce::ScopedLock sl (snapshotLock);
+    return { snapshots, activeSnapshot.load() };
+}
+
+void LifterProcessor::storeSnapshot (int index)
+{
+    const auto current = getCurrentValues();
+    
+    const juce::ScopedLock sl (snapshotLock);
+    snapshots[(size_t) index] = current;
+}
+
+void LifterProcessor::recallSnapshot (int index)
+{
+    Parameters::Values values;
+    
+    {
+        const juce::ScopedLock sl (snapshotLock);
+        values = snapshots[(size_t) index];
+        activeSnapshot = index;
+    }
+    
+    applySnapshot (values);
+}
+
+void LifterProcessor::switchSnapshot (int index)
+{
+    const auto current = getCurrentValues();
+    Parameters::Values values;
+    
+    // Store and switch in one step, so a state saved meanwhile sees either both or neither
+    {
+        const juce::ScopedLock sl (snapshotLock);
+        
+        if (index == activeSnapshot.load())
+            return;
+        
+        snapshots[(size_t) activeSnapshot.load()] = current;
+        values = snapshots[(size_t) index];
+        activeSnapshot = index;
+    }
+    
+    applySnapshot (values);
+}
+
+void LifterProcessor::applySnapshot (const Parameters::Values& values)
+{
+    // The audio thread switches the whole set at once, without waiting for the parameters below
+    recalledValues.getWriteBuffer() = values;
+    recalledValues.publish();
+    
+    // Keep the parameters in sync, telling the host only about the ones that actually change
+    for (size_t i = 0; i < Parameters::count; ++i)
+    {
+        if (values[i] == rawParams[i]->load())
+            continue;
+        
+        if (auto* parameter = apvts.getParameter (Parameters::ids[i]))
+            parameter->setValueNotifyingHost (parameter->convertTo0to1 (values[i]));
+    }
 }
 
 //==============================================================================
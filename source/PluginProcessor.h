@@ -1,7 +1,15 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
+#include <clap-juce-extensions/clap-juce-extensions.h>
 #include "punk_dsp/punk_dsp.h"
+#include "LifterEngine.h"
+#include "BlockProfiler.h"
+#include "GainTraceRecorder.h"
+#include "MeterFifo.h"
+#include "MultibandLifter.h"
+#include "ParameterRanges.h"
+#include "TripleBuffer.h"
 
 #if (MSVC)
 #include "ipps.h"
@@ -12,59 +20,212 @@ namespace Parameters
     // Ratio
     constexpr auto ratioId = "ratio";
     constexpr auto ratioName = "Ratio (:1)";
-    constexpr auto ratioDefault = 4.0f;
-    constexpr auto ratioMin = 1.0f;
-    constexpr auto ratioMax = 100.0f;
+    constexpr auto ratioDefault = ParameterRanges::ratio.defaultValue;
+    constexpr auto ratioMin = ParameterRanges::ratio.min;
+    constexpr auto ratioMax = ParameterRanges::ratio.max;
 
     // Threshold
     constexpr auto thresId = "thres";
     constexpr auto thresName = "Threshold (dB)";
-    constexpr auto thresDefault = -40.0f;
-    constexpr auto thresMin = -90.0f;
-    constexpr auto thresMax = 0.0f;
+    constexpr auto thresDefault = ParameterRanges::thres.defaultValue;
+    constexpr auto thresMin = ParameterRanges::thres.min;
+    constexpr auto thresMax = ParameterRanges::thres.max;
 
     // Knee width
     constexpr auto kneeId = "knee";
     constexpr auto kneeName = "Knee Width (dB)";
-    constexpr auto kneeDefault = 12.0f;
-    constexpr auto kneeMin = 1.0f;
-    constexpr auto kneeMax = 30.0f;
+    constexpr auto kneeDefault = ParameterRanges::knee.defaultValue;
+    constexpr auto kneeMin = ParameterRanges::knee.min;
+    constexpr auto kneeMax = ParameterRanges::knee.max;
 
     // Attack
     constexpr auto attackId = "attack";
     constexpr auto attackName = "Attack (ms)";
-    constexpr auto attackDefault = 15.0f;
-    constexpr auto attackMin = 0.1f;
-    constexpr auto attackMax = 250.0f;
+    constexpr auto attackDefault = ParameterRanges::attack.defaultValue;
+    constexpr auto attackMin = ParameterRanges::attack.min;
+    constexpr auto attackMax = ParameterRanges::attack.max;
 
     // Release
     constexpr auto releaseId = "release";
     constexpr auto releaseName = "Release (ms)";
-    constexpr auto releaseDefault = 60.0f;
-    constexpr auto releaseMin = 5.0f;
-    constexpr auto releaseMax = 3000.0f;
+    constexpr auto releaseDefault = ParameterRanges::release.defaultValue;
+    constexpr auto releaseMin = ParameterRanges::release.min;
+    constexpr auto releaseMax = ParameterRanges::release.max;
 
     // Makeup gain
     constexpr auto makeupId = "makeup";
     constexpr auto makeupName = "Makeup (dB)";
-    constexpr auto makeupDefault = 0.0f;
-    constexpr auto makeupMin = -30.0f;
-    constexpr auto makeupMax = 30.0f;
+    constexpr auto makeupDefault = ParameterRanges::makeup.defaultValue;
+    constexpr auto makeupMin = ParameterRanges::makeup.min;
+    constexpr auto makeupMax = ParameterRanges::makeup.max;
 
     // Comp topology
     constexpr auto feedId = "feed";
     constexpr auto feedName = "Feed Forward";
-    constexpr auto feedDefault = true;
+    constexpr auto feedDefault = ParameterRanges::feedForwardDefault;
 
     // Comp mix control
     constexpr auto mixId = "mix";
     constexpr auto mixName = "Comp Mix";
-    constexpr auto mixDefault = 100.f;
-    constexpr auto mixMin = 0.0f;
-    constexpr auto mixMax = 100.0f;
+    constexpr auto mixDefault = ParameterRanges::mix.defaultValue;
+    constexpr auto mixMin = ParameterRanges::mix.min;
+    constexpr auto mixMax = ParameterRanges::mix.max;
+
+    // Gain curve evaluation: exact (punk_dsp::Lifter) or a precomputed table
+    constexpr auto curveId = "curve";
+    constexpr auto curveName = "Gain Curve";
+    constexpr auto curveDefault = 0;
+    inline const juce::StringArray curveChoices { "Exact", "Table 8/oct", "Table 32/oct", "Table 128/oct" };
+
+    // Detector link across channels
+    constexpr auto linkId = "link";
+    constexpr auto linkName = "Channel Link";
+    constexpr auto linkDefault = 0;
+    inline const juce::StringArray linkChoices { "Per Channel", "Max", "RMS Average" };
+
+    // Eco mode: run the detector once every 4 to 32 samples and ramp the gain in between
+    constexpr auto ecoId = "eco";
+    constexpr auto ecoName = "Eco Mode";
+    constexpr auto ecoDefault = 0;
+    inline const juce::StringArray ecoChoices { "Off", "4 Samples", "8 Samples", "16 Samples", "32 Samples" };
+    constexpr int getEcoInterval (int choice) noexcept { return choice == 0 ? 1 : 2 << choice; }
+    
+    // True-peak detection: oversample the feed-forward sidechain 2x or 4x, the audio path stays at the base rate.
+    // Only LifterEngine has it, so on it also replaces punk_dsp::Lifter on the single-band path.
+    constexpr auto truePeakId = "truepeak";
+    constexpr auto truePeakName = "True Peak";
+    constexpr auto truePeakDefault = 0;
+    inline const juce::StringArray truePeakChoices { "Off", "2x", "4x" };
+    constexpr int getTruePeakFactor (int choice) noexcept { return 1 << choice; }
+
+    // Multiband: off (one band) or 2 to 6 bands with their own Lifter settings
+    constexpr auto bandsId = "bands";
+    constexpr auto bandsName = "Bands";
+    constexpr auto bandsDefault = 0;
+    inline const juce::StringArray bandsChoices { "Off", "2 Bands", "3 Bands", "4 Bands", "5 Bands", "6 Bands" };
+    constexpr int getNumBands (int choice) noexcept { return choice == 0 ? 1 : choice + 1; }
+    constexpr auto maxBands = MultibandLifter::maxBands;
+
+    // Crossovers, lowest first. N bands use the first N - 1.
+    constexpr std::array<const char*, maxBands - 1> xoverIds { "xover1", "xover2", "xover3", "xover4", "xover5" };
+    constexpr std::array<float, maxBands - 1> xoverDefaults { 120.0f, 500.0f, 2000.0f, 5000.0f, 10000.0f };
+    constexpr auto xoverMin = 20.0f;
+    constexpr auto xoverMax = 20000.0f;
+
+    // Largest bus we accept. The audio thread takes non-owning AudioBuffer views of sub-blocks,
+    // which use JUCE's preallocated channel array only below 32 channels and malloc from 32 on.
+    constexpr auto maxChannels = 31;
+
+    // Index of every parameter, used for change tracking. The per-band parameters follow the
+    // global ones, band by band, each band with the same set as the main Lifter.
+    enum class Index { ratio, thres, knee, attack, release, makeup, feed, mix, curve, link, eco, truePeak,
+                       bands, xover1, xover2, xover3, xover4, xover5, firstBand };
+    enum class BandIndex { ratio, thres, knee, attack, release, makeup, count };
+
+    constexpr auto numBandParams = static_cast<size_t> (BandIndex::count);
+    constexpr auto firstBand = static_cast<size_t> (Index::firstBand);
+    constexpr auto count = firstBand + maxBands * numBandParams;
+
+    constexpr std::array<const char*, count> ids { ratioId, thresId, kneeId, attackId, releaseId, makeupId, feedId, mixId, curveId, linkId, ecoId, truePeakId,
+                                                   bandsId, xoverIds[0], xoverIds[1], xoverIds[2], xoverIds[3], xoverIds[4],
+                                                   "band1_ratio", "band1_thres", "band1_knee", "band1_attack", "band1_release", "band1_makeup",
+                                                   "band2_ratio", "band2_thres", "band2_knee", "band2_attack", "band2_release", "band2_makeup",
+                                                   "band3_ratio", "band3_thres", "band3_knee", "band3_attack", "band3_release", "band3_makeup",
+                                                   "band4_ratio", "band4_thres", "band4_knee", "band4_attack", "band4_release", "band4_makeup",
+                                                   "band5_ratio", "band5_thres", "band5_knee", "band5_attack", "band5_release", "band5_makeup",
+                                                   "band6_ratio", "band6_thres", "band6_knee", "band6_attack", "band6_release", "band6_makeup" };
+
+    // Everything createParams() needs to build a parameter, one entry per id above, so a new
+    // instance builds its layout with one loop over static data
+    enum class Kind { continuous, toggle, choice };
+    
+    struct Descriptor
+    {
+        const char* id = nullptr;
+        const char* name = nullptr;
+        Kind kind = Kind::continuous;
+        float min = 0.0f, max = 1.0f, step = 0.0f, defaultValue = 0.0f;
+        float skewCentre = 0.0f;                        // 0: linear range
+        const juce::StringArray* choices = nullptr;     // Kind::choice only
+        int band = 0;                                   // 1 to maxBands for per-band parameters, named "Band N ..."
+    };
+    
+    constexpr std::array<Descriptor, firstBand> globalDescriptors {{
+        { ratioId,   ratioName,   Kind::continuous, ratioMin,   ratioMax,   0.1f, ratioDefault },
+        { thresId,   thresName,   Kind::continuous, thresMin,   thresMax,   0.1f, thresDefault },
+        { kneeId,    kneeName,    Kind::continuous, kneeMin,    kneeMax,    0.1f, kneeDefault },
+        { attackId,  attackName,  Kind::continuous, attackMin,  attackMax,  0.1f, attackDefault },
+        { releaseId, releaseName, Kind::continuous, releaseMin, releaseMax, 0.1f, releaseDefault },
+        { makeupId,  makeupName,  Kind::continuous, makeupMin,  makeupMax,  0.1f, makeupDefault },
+        { feedId,    feedName,    Kind::toggle,     0.0f, 1.0f, 1.0f, feedDefault ? 1.0f : 0.0f },
+        { mixId,     mixName,     Kind::continuous, mixMin,     mixMax,     1.0f, mixDefault },
+        { curveId,   curveName,   Kind::choice,     0.0f, 3.0f, 1.0f, (float) curveDefault, 0.0f, &curveChoices },
+        { linkId,    linkName,    Kind::choice,     0.0f, 2.0f, 1.0f, (float) linkDefault,  0.0f, &linkChoices },
+        { ecoId,     ecoName,     Kind::choice,     0.0f, 4.0f, 1.0f, (float) ecoDefault,   0.0f, &ecoChoices },
+        { truePeakId, truePeakName, Kind::choice,   0.0f, 2.0f, 1.0f, (float) truePeakDefault, 0.0f, &truePeakChoices },
+        { bandsId,   bandsName,   Kind::choice,     0.0f, 5.0f, 1.0f, (float) bandsDefault, 0.0f, &bandsChoices },
+        { xoverIds[0], "Crossover 1 (Hz)", Kind::continuous, xoverMin, xoverMax, 1.0f, xoverDefaults[0], 1000.0f },
+        { xoverIds[1], "Crossover 2 (Hz)", Kind::continuous, xoverMin, xoverMax, 1.0f, xoverDefaults[1], 1000.0f },
+        { xoverIds[2], "Crossover 3 (Hz)", Kind::continuous, xoverMin, xoverMax, 1.0f, xoverDefaults[2], 1000.0f },
+        { xoverIds[3], "Crossover 4 (Hz)", Kind::continuous, xoverMin, xoverMax, 1.0f, xoverDefaults[3], 1000.0f },
+        { xoverIds[4], "Crossover 5 (Hz)", Kind::continuous, xoverMin, xoverMax, 1.0f, xoverDefaults[4], 1000.0f }
+    }};
+    
+    // Every band repeats the main Lifter's ranges
+    constexpr auto descriptors = []
+    {
+        std::array<Descriptor, count> table {};
+        
+        for (size_t i = 0; i < firstBand; ++i)
+            table[i] = globalDescriptors[i];
+        
+        for (size_t i = firstBand; i < count; ++i)
+        {
+            table[i] = globalDescriptors[(i - firstBand) % numBandParams];
+            table[i].id = ids[i];
+            table[i].band = (int) ((i - firstBand) / numBandParams) + 1;
+        }
+        
+        return table;
+    }();
+    
+    constexpr bool descriptorsMatchIds()
+    {
+        for (size_t i = 0; i < count; ++i)
+            if (std::string_view (descriptors[i].id) != std::string_view (ids[i]))
+                return false;
+        
+        return true;
+    }
+    
+    static_assert (descriptorsMatchIds());
+    
+    // Ramp length for the smoothed parameters (threshold, makeup and mix)
+    constexpr auto smoothingSeconds = 0.05;
+    // While a ramp is running, the Lifter is updated every this many samples
+    constexpr auto smoothingStep = 16;
+
+    // Input blocks whose peak stays below this (-120 dBFS) count as silence
+    constexpr auto silenceFloor = 1.0e-6f;
+    // Release time constants for the gain to settle within 1 % (ln 100), for the reported tail
+    constexpr auto settleTimeConstants = 4.6;
+    // A silent sub-block that moves the gain addition by no more than this (dB) leaves the detector settled
+    constexpr auto settleToleranceDb = 1.0e-5f;
+
+    // Internal processing granularity: host buffers are split into sub-blocks of this many samples
+    constexpr auto subBlockDefault = 128;
+    constexpr auto subBlockMin = 64;
+    constexpr auto subBlockMax = 256;
+
+    // In-memory parameter snapshots the editor can switch between (A/B)
+    constexpr auto numSnapshots = 2;
+    using Values = std::array<float, count>;
+    using Snapshots = std::array<Values, numSnapshots>;
 }
 
-class LifterProcessor : public juce::AudioProcessor
+class LifterProcessor : public juce::AudioProcessor,
+                        public clap_juce_extensions::clap_juce_audio_processor_capabilities,
+                        private juce::AudioProcessorValueTreeState::Listener
 {
 public:
     LifterProcessor();
@@ -77,6 +238,9 @@ public:
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
+    void setNonRealtime (bool isNonRealtime) noexcept override;
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -102,13 +266,135 @@ public:
     
     void updateParameters();
     
-    float sendGainAddition(){ return lifter.getGainAddition(); }
+    float sendGainAddition()
+    {
+        if (multiband.getNumBands() > 1)
+            return multiband.getGainAddition();
+        
+        return useEngine ? engine.getGainAddition() : lifter.getGainAddition();
+    }
+    
+    // Whether LifterEngine rather than punk_dsp::Lifter runs the single-band path, any thread
+    bool isUsingEngine() const noexcept { return useEngine.load (std::memory_order_relaxed); }
+    
+    // Metering stream for the editor, only fed while an editor is open
+    MeterFifo meterFifo;
+    void setMeteringActive (bool shouldBeActive) { meteringActive.store (shouldBeActive, std::memory_order_relaxed); }
+    
+    // Snapshots, message thread only, though the host may save them from any thread.
+    // Switching stores the current settings in the active snapshot and recalls the other one.
+    void storeSnapshot (int index);
+    void recallSnapshot (int index);
+    void switchSnapshot (int index);
+    int getActiveSnapshot() const noexcept { return activeSnapshot.load(); }
+    
+    // Sub-block length, clamped to subBlockMin..subBlockMax. Takes effect on the next prepareToPlay.
+    void setSubBlockSize (int newSize);
+    int getSubBlockSize() const noexcept { return subBlockSize; }
+    
+    // Gain trace to a file, see GainTraceRecorder for the format. Message thread or offline tools.
+    bool startGainTrace (const juce::File& file, int samplesPerRecord = 1) { return gainTrace.start (file, getSampleRate(), samplesPerRecord); }
+    void stopGainTrace() { gainTrace.stop(); }
+    bool isRecordingGainTrace() const noexcept { return gainTrace.isRecording(); }
+    juce::int64 getGainTraceDropped() const noexcept { return gainTrace.getNumRecordsDropped(); }
+    
+    // CLAP hosts hand the process call to the processor directly, so parameter events are
+    // applied at their sample offsets instead of once per block. Other formats use processBlock.
+    bool supportsDirectProcess() override { return true; }
+    clap_process_status clap_direct_process (const clap_process* process) noexcept override;
+    
+   #if LIFTER_PROFILING
+    // Per-block timings of the two halves of processBlock, readable from any thread
+    enum class ProfileStage { parameters, process };
+    BlockProfiler::Stats getProfileStats (ProfileStage stage) const noexcept;
+    void resetProfile() noexcept;
+   #endif
 
 private:
     juce::AudioProcessorValueTreeState::ParameterLayout createParams();
     
+    void parameterChanged (const juce::String& parameterID, float newValue) override;
+    void pushParameter (Parameters::Index index, float value);
+    void pushBandParameter (int band, Parameters::BandIndex index, float value);
+    // Both processBlock overloads run these, instantiated for float and double
+    template <typename SampleType> void processBlockImpl (juce::AudioBuffer<SampleType>& buffer);
+    // The input is either a view of the output (processBlock) or separate host memory (CLAP).
+    // LifterEngine reads it where it is; stages that only run in place get it copied in first.
+    // That includes the default path, punk_dsp::Lifter, which also keeps its own dry copy, so
+    // the zero-copy path only runs when the engine is selected (see updateEngineSelection).
+    template <typename SampleType> void processRange (const juce::dsp::AudioBlock<const SampleType>& input, juce::AudioBuffer<SampleType>& output);
+    template <typename SampleType> void processMultiband (juce::AudioBuffer<SampleType>& buffer);
+    template <typename SampleType> void processSubBlock (const juce::dsp::AudioBlock<const SampleType>& input, juce::AudioBuffer<SampleType>& output);
+    template <typename SampleType> void processSmoothed (const juce::dsp::AudioBlock<const SampleType>& input, juce::AudioBuffer<SampleType>& output);
+    template <typename SampleType> void processLifter (const juce::dsp::AudioBlock<const SampleType>& input, juce::AudioBuffer<SampleType>& output);
+    void applyParameterEvent (const clap_event_param_value& event);
+    void updateEngineSelection();
+    void pushMeterFrame (float inputPeak, float outputPeak, int numSamples);
+    float getAppliedGain();
+    bool isSmoothing() const noexcept;
+    Parameters::Values getCurrentValues() const;
+    std::pair<Parameters::Snapshots, int> getSnapshots() const;
+    void applySnapshot (const Parameters::Values& values);
+    
     punk_dsp::Lifter lifter;
     
+    // punk_dsp::Lifter is float only, double blocks run on a converted copy in here
+    juce::AudioBuffer<float> floatScratch;
+    
+    // Plugin-side Lifter used by the optimised modes, kept in sync with the same parameters
+    LifterEngine engine;
+    GainCurve::Resolution curveResolution = GainCurve::Resolution::exact;
+    LifterEngine::Link linkMode = LifterEngine::Link::perChannel;
+    int ecoInterval = 1;
+    int truePeakFactor = 1;
+    std::atomic<bool> useEngine { false };
+    
+    // Band bank for the multiband mode, in use whenever more than one band is selected
+    MultibandLifter multiband;
+    
+    // Change tracking: the listener flags a parameter, the audio thread pushes only flagged ones
+    std::array<std::atomic<float>*, Parameters::count> rawParams {};
+    std::array<std::atomic<bool>, Parameters::count> dirtyParams {};
+    std::atomic<bool> anyParamDirty { false };
+    
+    // CLAP parameter events address parameters by these ids
+    std::array<juce::RangedAudioParameter*, Parameters::count> parameters {};
+    std::array<clap_id, Parameters::count> clapParamIds {};
+    
+    // Recalled snapshots reach the audio thread as a whole set in one swap. The lock keeps the
+    // set and the active index consistent for hosts that save the state from another thread.
+    Parameters::Snapshots snapshots {};
+    juce::CriticalSection snapshotLock;
+    TripleBuffer<Parameters::Values> recalledValues;
+    std::atomic<int> activeSnapshot { 0 };
+    
+    // Per-sample ramps for the parameters that zipper when automated. The bands take the mix
+    // ramp and have threshold and makeup ramps of their own.
+    juce::SmoothedValue<float> thresSmoothed, makeupSmoothed, mixSmoothed;
+    std::array<juce::SmoothedValue<float>, Parameters::maxBands> bandThresSmoothed, bandMakeupSmoothed;
+    
+    std::atomic<int> requestedSubBlockSize { Parameters::subBlockDefault };
+    int subBlockSize = Parameters::subBlockDefault;
+    
+    // Silence tracking: once the input is silent and the active Lifter's gain addition has
+    // stopped moving, the detector has nothing left to do and the block is just scaled by
+    // the gain the Lifter applied last
+    bool settled = false;
+    float lastGainAddition = 0.0f;
+    float heldGain = 1.0f;
+    
+    // Peaks are accumulated across blocks and sent every samplesPerFrame samples
+    std::atomic<bool> meteringActive { false };
+    MeterFrame pendingFrame;
+    int pendingSamples = 0;
+    int samplesPerFrame = 1;
+    
+    GainTraceRecorder gainTrace;
+    
+   #if LIFTER_PROFILING
+    BlockProfiler parameterProfiler, processProfiler;
+   #endif
+    
     // =============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LifterProcessor)
 };
@@ -0,0 +1,89 @@
+#include "PluginState.h"
+#include <bit>
+
+namespace
+{
+    void put32 (char*& dest, juce::uint32 value) noexcept
+    {
+        value = juce::ByteOrder::swapIfBigEndian (value);
+        std::memcpy (dest, &value, sizeof (value));
+        dest += sizeof (value);
+    }
+
+    void put16 (char*& dest, juce::uint16 value) noexcept
+    {
+        value = juce::ByteOrder::swapIfBigEndian (value);
+        std::memcpy (dest, &value, sizeof (value));
+        dest += sizeof (value);
+    }
+
+    juce::uint32 get32 (const char* source) noexcept { return juce::ByteOrder::littleEndianInt (source); }
+    juce::uint16 get16 (const char* source) noexcept { return juce::ByteOrder::littleEndianShort (source); }
+}
+
+namespace PluginState
+{
+    bool isBinaryState (const void* data, size_t sizeInBytes) noexcept
+    {
+        return sizeInBytes >= headerSize && get32 (static_cast<const char*> (data)) == magic;
+    }
+
+    void write (juce::MemoryBlock& dest, std::span<const char* const> ids, std::span<const float* const> sets, int activeSnapshot)
+    {
+        const auto size = getSize (ids.size(), sets.size());
+
+        if (dest.getSize() != size)
+            dest.setSize (size);
+
+        auto* out = static_cast<char*> (dest.getData());
+
+        put32 (out, magic);
+        put16 (out, version);
+        put16 (out, (juce::uint16) ids.size());
+        put16 (out, (juce::uint16) sets.size());
+        put16 (out, (juce::uint16) (juce::int16) activeSnapshot);
+        put32 (out, 0);
+
+        for (auto* id : ids)
+            put32 (out, hashId (id));
+
+        for (auto* values : sets)
+            for (size_t i = 0; i < ids.size(); ++i)
+                put32 (out, std::bit_cast<juce::uint32> (values[i]));
+    }
+
+    bool read (const void* data, size_t sizeInBytes, std::span<const char* const> ids, std::span<float* const> sets, int& activeSnapshot)
+    {
+        if (! isBinaryState (data, sizeInBytes))
+            return false;
+
+        const auto* in = static_cast<const char*> (data);
+        const auto storedVersion = get16 (in + 4);
+        const size_t numParams = get16 (in + 6);
+        const size_t numSets = get16 (in + 8);
+
+        // Later versions may append fields, but never change what is here
+        if (storedVersion < 1 || sizeInBytes < getSize (numParams, numSets))
+            return false;
+
+        const auto* storedIds = in + headerSize;
+        const auto* storedValues = storedIds + numParams * sizeof (juce::uint32);
+
+        for (size_t p = 0; p < numParams; ++p)
+        {
+            const auto hash = get32 (storedIds + p * sizeof (juce::uint32));
+            const auto match = std::find_if (ids.begin(), ids.end(), [hash] (const char* id) { return hashId (id) == hash; });
+
+            if (match == ids.end())
+                continue;
+
+            const auto index = (size_t) std::distance (ids.begin(), match);
+
+            for (size_t s = 0; s < juce::jmin (numSets, sets.size()); ++s)
+                sets[s][index] = std::bit_cast<float> (get32 (storedValues + (s * numParams + p) * sizeof (float)));
+        }
+
+        activeSnapshot = (juce::int16) get16 (in + 10);
+        return true;
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <span>
+
+// Compact binary plugin state.
+//
+// Layout, little-endian:
+//   header   magic "LftS", uint16 version, uint16 numParams, uint16 numSets, int16 activeSnapshot, uint32 reserved
+//   ids      numParams x uint32, FNV-1a hash of each parameter id
+//   values   numSets x numParams x float32, the live parameter set first, then the snapshots
+//
+// Values are matched back to parameters by id hash, so parameters can be added, removed or
+// reordered between versions: unknown ids are skipped and missing ones keep their value.
+// States written before this format (APVTS XML through copyXmlToBinary) are told apart by
+// the magic number and still load.
+namespace PluginState
+{
+    constexpr juce::uint32 magic = 0x5374664c; // "LftS" in file byte order
+    constexpr juce::uint16 version = 1;
+    constexpr size_t headerSize = 16;
+
+    constexpr juce::uint32 hashId (const char* id) noexcept
+    {
+        juce::uint32 hash = 2166136261u;
+
+        for (; *id != 0; ++id)
+            hash = (hash ^ (juce::uint8) *id) * 16777619u;
+
+        return hash;
+    }
+
+    constexpr size_t getSize (size_t numParams, size_t numSets) noexcept
+    {
+        return headerSize + numParams * sizeof (juce::uint32) + numSets * numParams * sizeof (float);
+    }
+
+    bool isBinaryState (const void* data, size_t sizeInBytes) noexcept;
+
+    // Writes every set in one pass into dest, which is only resized if it has the wrong size
+    void write (juce::MemoryBlock& dest, std::span<const char* const> ids, std::span<const float* const> sets, int activeSnapshot);
+
+    // Fills the sets that are present in the data. Returns false, leaving everything untouched,
+    // if the data is not a valid binary state.
+    bool read (const void* data, size_t sizeInBytes, std::span<const char* const> ids, std::span<float* const> sets, int& activeSnapshot);
+}
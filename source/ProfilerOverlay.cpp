@@ -0,0 +1,50 @@
+#include "ProfilerOverlay.h"
+
+#if LIFTER_PROFILING
+
+ProfilerOverlay::ProfilerOverlay (LifterProcessor& p)
+    : processorRef (p)
+{
+    setInterceptsMouseClicks (true, false);
+}
+
+void ProfilerOverlay::update()
+{
+    auto describe = [] (const char* name, const BlockProfiler::Stats& stats)
+    {
+        return juce::String (name) + ": min " + juce::String (stats.minNs / 1000.0, 1)
+             + " / mean " + juce::String (stats.meanNs / 1000.0, 1)
+             + " / p99 " + juce::String (stats.p99Ns / 1000.0, 1)
+             + " / max " + juce::String (stats.maxNs / 1000.0, 1) + " us, budget "
+             + juce::String (stats.meanBudgetPercent, 2) + " % mean, "
+             + juce::String (stats.maxBudgetPercent, 2) + " % max";
+    };
+
+    const auto parameters = processorRef.getProfileStats (LifterProcessor::ProfileStage::parameters);
+    const auto process = processorRef.getProfileStats (LifterProcessor::ProfileStage::process);
+
+    lines.clearQuick();
+    lines.add ("Blocks: " + juce::String (process.numBlocks) + " (click to reset)");
+    lines.add (describe ("Params", parameters));
+    lines.add (describe ("Process", process));
+
+    repaint();
+}
+
+void ProfilerOverlay::paint (juce::Graphics& g)
+{
+    g.fillAll (juce::Colours::black.withAlpha (0.8f));
+    g.setColour (juce::Colours::white);
+    g.setFont (resources->monospacedFont);
+
+    auto area = getLocalBounds().reduced (6);
+    for (const auto& line : lines)
+        g.drawText (line, area.removeFromTop (16), juce::Justification::centredLeft, true);
+}
+
+void ProfilerOverlay::mouseUp (const juce::MouseEvent&)
+{
+    processorRef.resetProfile();
+}
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "PluginProcessor.h"
+#include "EditorResources.h"
+
+#if LIFTER_PROFILING
+
+//==============================================================================
+// Hidden editor overlay with the processor's per-block timings.
+// Toggled with Ctrl/Cmd + Shift + P, click it to reset the stats.
+class ProfilerOverlay : public juce::Component
+{
+public:
+    explicit ProfilerOverlay (LifterProcessor&);
+
+    // Called from the editor once per display refresh while visible
+    void update();
+
+    void paint (juce::Graphics&) override;
+    void mouseUp (const juce::MouseEvent&) override;
+
+private:
+    LifterProcessor& processorRef;
+    juce::SharedResourcePointer<EditorResources> resources;
+    juce::StringArray lines;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProfilerOverlay)
+};
+
+#endif
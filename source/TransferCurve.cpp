@@ -0,0 +1,122 @@
+#include "TransferCurve.h"
+#include "punk_dsp/punk_dsp.h"
+
+TransferCurve::TransferCurve()
+{
+    setOpaque (true);
+    table.allocate();
+}
+
+void TransferCurve::setState (const State& newState)
+{
+    if (newState == state)
+        return;
+
+    state = newState;
+    cache = {};
+    repaint();
+}
+
+void TransferCurve::resized()
+{
+    cache = {};
+}
+
+void TransferCurve::paint (juce::Graphics& g)
+{
+    // Drawn at the physical pixel size, so the blit is 1:1 on high-DPI screens too
+    const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (! cache.isValid() || scale != cacheScale)
+        renderCurve (scale);
+
+    g.drawImage (cache, getLocalBounds().toFloat());
+}
+
+void TransferCurve::renderCurve (float scale)
+{
+    const auto width = juce::jmax (1, juce::roundToInt ((float) getWidth() * scale));
+    const auto height = juce::jmax (1, juce::roundToInt ((float) getHeight() * scale));
+
+    cache = juce::Image (juce::Image::ARGB, width, height, false);
+    cacheScale = scale;
+
+    juce::Graphics g (cache);
+    g.addTransform (juce::AffineTransform::scale (scale));
+
+    const auto bounds = getLocalBounds().toFloat();
+    g.fillAll (punk_dsp::UIConstants::background);
+    g.setColour (punk_dsp::UIConstants::background.brighter (0.5f).withAlpha (0.25f));
+    g.fillRect (bounds);
+
+    auto toX = [&bounds] (float db) { return juce::jmap (db, minDb, maxDb, bounds.getX(), bounds.getRight()); };
+    auto toY = [&bounds] (float db) { return juce::jmap (juce::jlimit (minDb, maxDb, db), minDb, maxDb, bounds.getBottom(), bounds.getY()); };
+
+    // Unity line
+    g.setColour (juce::Colours::white.withAlpha (0.2f));
+    g.drawLine (toX (minDb), toY (minDb), toX (maxDb), toY (maxDb), 1.0f);
+
+    // The table is what the engine looks the gain up in, the exact curve is what punk_dsp::Lifter computes
+    const auto useTable = state.usesEngine && state.resolution != GainCurve::Resolution::exact;
+    const auto numCurves = juce::jlimit (1, maxCurves, state.numCurves);
+    const auto numPoints = juce::jmax (2, getWidth());
+
+    for (int c = 0; c < numCurves; ++c)
+    {
+        const auto& settings = state.curves[(size_t) c];
+
+        if (useTable)
+            table.build (settings, state.resolution);
+
+        const auto colour = numCurves == 1 ? juce::Colours::orange
+                                           : juce::Colours::orange.withRotatedHue ((float) c / (float) numCurves);
+
+        // Threshold marker
+        g.setColour (colour.withAlpha (0.25f));
+        g.drawVerticalLine (juce::roundToInt (toX (settings.thres)), bounds.getY(), bounds.getBottom());
+
+        // One point per horizontal pixel is plenty, the knee is the only curved part
+        juce::Path curve;
+
+        for (int i = 0; i < numPoints; ++i)
+        {
+            const auto inputDb = juce::jmap ((float) i, 0.0f, (float) (numPoints - 1), minDb, maxDb);
+            const auto level = juce::Decibels::decibelsToGain (inputDb, -1000.0f);
+            const auto gain = useTable ? table.lookup (level) : GainCurve::computeGain (level, settings);
+            const auto outputDb = inputDb + juce::Decibels::gainToDecibels (1.0f + state.mix * (gain - 1.0f), -1000.0f);
+
+            if (i == 0)
+                curve.startNewSubPath (toX (inputDb), toY (outputDb));
+            else
+                curve.lineTo (toX (inputDb), toY (outputDb));
+        }
+
+        g.setColour (colour);
+        g.strokePath (curve, juce::PathStrokeType (1.5f));
+    }
+
+    g.setColour (juce::Colours::white.withAlpha (0.6f));
+    g.setFont (resources->labelFont);
+    g.drawText (getLabel(), bounds.reduced (4.0f), juce::Justification::bottomRight, true);
+}
+
+juce::String TransferCurve::getLabel() const
+{
+    if (! state.usesEngine)
+        return "punk_dsp::Lifter";
+
+    juce::String label ("LifterEngine");
+
+    if (state.numCurves > 1)
+        label << ", " << state.numCurves << " bands";
+
+    switch (state.resolution)
+    {
+        case GainCurve::Resolution::exact:  break;
+        case GainCurve::Resolution::coarse: label << ", coarse table"; break;
+        case GainCurve::Resolution::medium: label << ", medium table"; break;
+        case GainCurve::Resolution::fine:   label << ", fine table"; break;
+    }
+
+    return label;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "EditorResources.h"
+#include "GainCurve.h"
+
+//==============================================================================
+// Static input/output curve of the DSP the processor is running: punk_dsp::Lifter's curve
+// (modelled by GainCurve, which LifterNullTest holds to 0.05 dB), the engine's table when one
+// is selected, or one curve per band in multiband, each for a signal inside that band alone.
+// Dry/wet mix is included, and a label names the DSP the curve belongs to.
+// The curve is drawn once into a cached image at the display's pixel scale, and redrawn
+// only when the state or the size change. Other repaints just blit the image.
+class TransferCurve : public juce::Component
+{
+public:
+    static constexpr float minDb = -90.0f;
+    static constexpr float maxDb = 0.0f;
+    static constexpr int maxCurves = 6;
+
+    struct State
+    {
+        std::array<GainCurve::Settings, maxCurves> curves {};
+        int numCurves = 1;                                          // More than one means multiband
+        GainCurve::Resolution resolution = GainCurve::Resolution::exact;
+        float mix = 1.0f;                                           // 0 to 1
+        bool usesEngine = false;                                    // LifterEngine rather than punk_dsp::Lifter
+
+        bool operator== (const State&) const = default;
+    };
+
+    TransferCurve();
+
+    // Message thread. Does nothing unless the state differs from the drawn one.
+    void setState (const State& newState);
+
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+private:
+    void renderCurve (float scale);
+    juce::String getLabel() const;
+
+    juce::SharedResourcePointer<EditorResources> resources;
+    State state;
+    GainCurve::Table table;
+    juce::Image cache;
+    float cacheScale = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TransferCurve)
+};
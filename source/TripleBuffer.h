@@ -0,0 +1,49 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+// Lock-free hand-over of a value from one writer thread to one reader thread.
+// The writer fills getWriteBuffer() and calls publish(), the reader calls update()
+// and then reads getReadBuffer(). Neither side ever waits, and the three buffers
+// are allocated up front, so a swap is a single atomic exchange.
+template <typename Type>
+class TripleBuffer
+{
+public:
+    // Writer side
+    Type& getWriteBuffer() noexcept { return buffers[(size_t) writeIndex]; }
+
+    void publish() noexcept
+    {
+        writeIndex = state.exchange (writeIndex | freshBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // Reader side. Returns true if a newer buffer was picked up.
+    bool update() noexcept
+    {
+        if ((state.load (std::memory_order_relaxed) & freshBit) == 0)
+            return false;
+
+        readIndex = state.exchange (readIndex, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    const Type& getReadBuffer() const noexcept { return buffers[(size_t) readIndex]; }
+
+    // Unsynchronised access, only while neither side can be running
+    template <typename Callback>
+    void forEachBuffer (Callback&& callback)
+    {
+        for (auto& buffer : buffers)
+            callback (buffer);
+    }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int freshBit = 4;
+
+    std::array<Type, 3> buffers {};
+    int writeIndex = 0;
+    int readIndex = 1;
+    std::atomic<int> state { 2 };
+};
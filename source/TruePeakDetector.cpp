@@ -0,0 +1,159 @@
+#include "TruePeakDetector.h"
+
+namespace
+{
+    // Odd phase of a Blackman-windowed sinc half-band filter, scaled for unity gain at DC.
+    // Coefficient k weighs the two inputs k + 0.5 samples either side of the midpoint.
+    template <typename SampleType, size_t half>
+    std::array<SampleType, half> designHalfBand()
+    {
+        std::array<SampleType, half> coefficients {};
+        auto sum = 0.0;
+
+        for (size_t k = 0; k < half; ++k)
+        {
+            const auto t = (double) k + 0.5;
+            const auto window = 0.42 + 0.5 * std::cos (juce::MathConstants<double>::pi * t / (double) half)
+                                     + 0.08 * std::cos (juce::MathConstants<double>::twoPi * t / (double) half);
+            const auto sinc = std::sin (juce::MathConstants<double>::pi * t) / (juce::MathConstants<double>::pi * t);
+
+            coefficients[k] = (SampleType) (sinc * window);
+            sum += 2.0 * sinc * window;
+        }
+
+        for (auto& c : coefficients)
+            c = (SampleType) (c / sum);
+
+        return coefficients;
+    }
+}
+
+template <typename SampleType>
+TruePeakDetector<SampleType>::TruePeakDetector()
+{
+    const auto c1 = designHalfBand<SampleType, stage1Half>();
+    const auto c2 = designHalfBand<SampleType, stage2Half>();
+
+    for (size_t k = 0; k < stage1.size(); ++k)
+        stage1[k] = Vec::expand (c1[k]);
+
+    for (size_t k = 0; k < stage2.size(); ++k)
+        stage2[k] = Vec::expand (c2[k]);
+}
+
+template <typename SampleType>
+void TruePeakDetector<SampleType>::prepare (int numChannels, int maxBlockSize)
+{
+    groups.resize ((size_t) ((numChannels + lanes - 1) / lanes));
+    levels.setSize (numChannels, maxBlockSize);
+    reset();
+}
+
+template <typename SampleType>
+void TruePeakDetector<SampleType>::reset()
+{
+    for (auto& group : groups)
+    {
+        group.input.fill (Vec::expand (0));
+        group.upsampled.fill (Vec::expand (0));
+        group.inputPosition = 0;
+        group.upsampledPosition = 0;
+    }
+}
+
+template <typename SampleType>
+void TruePeakDetector<SampleType>::setFactor (int newFactor)
+{
+    newFactor = newFactor >= 4 ? 4 : newFactor >= 2 ? 2 : 1;
+
+    if (newFactor != factor)
+    {
+        factor = newFactor;
+        reset();
+    }
+}
+
+//==============================================================================
+// Pushes value and returns the window of the last 2 * half inputs, oldest first
+template <typename SampleType>
+template <int half>
+const typename TruePeakDetector<SampleType>::Vec* TruePeakDetector<SampleType>::push (std::array<Vec, 4 * half>& history, int& position, Vec value) noexcept
+{
+    constexpr int length = 2 * half;
+
+    position = position + 1 == length ? 0 : position + 1;
+    history[(size_t) position] = value;
+    history[(size_t) (position + length)] = value;
+
+    return history.data() + position + 1;
+}
+
+// Value halfway between window[half - 1] and window[half]
+template <typename SampleType>
+template <int half>
+typename TruePeakDetector<SampleType>::Vec TruePeakDetector<SampleType>::interpolate (const Vec* window, const std::array<Vec, (size_t) half>& coefficients) noexcept
+{
+    auto sum = Vec::expand (0);
+
+    for (int k = 0; k < half; ++k)
+        sum = Vec::multiplyAdd (sum, coefficients[(size_t) k], window[half - 1 - k] + window[half + k]);
+
+    return sum;
+}
+
+template <typename SampleType>
+void TruePeakDetector<SampleType>::process (const juce::dsp::AudioBlock<const SampleType>& input, int startSample, int numChannels, int numSamples) noexcept
+{
+    jassert (numSamples <= levels.getNumSamples() && numChannels <= levels.getNumChannels());
+
+    alignas (Vec::SIMDRegisterSize) SampleType lane[lanes];
+
+    for (int g = 0; g * lanes < numChannels; ++g)
+    {
+        auto& group = groups[(size_t) g];
+        const auto firstChannel = g * lanes;
+        const auto groupChannels = juce::jmin (lanes, numChannels - firstChannel);
+
+        const SampleType* channels[lanes] {};
+        for (int l = 0; l < groupChannels; ++l)
+            channels[l] = input.getChannelPointer ((size_t) (firstChannel + l)) + startSample;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            // Gather one sample of every channel in the group into the lanes, unused lanes stay 0
+            for (int l = 0; l < lanes; ++l)
+                lane[l] = l < groupChannels ? channels[l][i] : (SampleType) 0;
+
+            // 2x: the delayed input sample and the midpoint after it
+            const auto* window = push<stage1Half> (group.input, group.inputPosition, Vec::fromRawArray (lane));
+            const auto centre = window[stage1Half - 1];
+            const auto middle = interpolate<stage1Half> (window, stage1);
+
+            auto peak = Vec::expand (0);
+
+            if (factor == 4)
+            {
+                // 4x: both 2x points go through the second stage, which returns them delayed
+                // together with the quarter point after each
+                for (auto point : { centre, middle })
+                {
+                    const auto* upsampled = push<stage2Half> (group.upsampled, group.upsampledPosition, point);
+                    peak = Vec::max (peak, Vec::max (Vec::abs (upsampled[stage2Half - 1]), Vec::abs (interpolate<stage2Half> (upsampled, stage2))));
+                }
+            }
+            else
+            {
+                peak = Vec::max (Vec::abs (centre), Vec::abs (middle));
+            }
+
+            peak.copyToRawArray (lane);
+
+            for (int l = 0; l < groupChannels; ++l)
+                levels.getWritePointer (firstChannel + l)[i] = lane[l];
+        }
+    }
+}
+
+//==============================================================================
+template class TruePeakDetector<float>;
+template class TruePeakDetector<double>;
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+//==============================================================================
+// Inter-sample peak measurement for the Lifter's sidechain. The audio itself is never
+// oversampled: only the detector input is, so the audio path keeps its rate and latency.
+//
+// For every input sample the detector reports the largest magnitude among the oversampled
+// points of that sample interval. Oversampling is a polyphase half-band interpolator:
+// the even phase of a half-band filter is the delayed input itself, so only the odd phase,
+// a symmetric FIR, is computed. 4x runs a shorter second 2x stage on the first one's output,
+// which is already band-limited to a quarter of its rate.
+//
+// The FIRs are vectorised across channels: each SIMD lane carries one channel, so a stereo
+// pair costs one vector pass. The measurement lags the input by getLatency() samples
+// (10 at 4x, 0.2 ms at 48 kHz), which only delays the detector, never the audio.
+//
+// Measured detector cost for a float stereo stream, 512-sample blocks, SSE lanes, -O3 on an
+// x86-64 Xeon: 23 ns per frame at 2x and 32 ns at 4x, so 0.10 % / 0.14 % of one core at
+// 44.1 kHz and 0.22 % / 0.31 % at 96 kHz. The per-frame cost does not depend on the rate.
+// This excludes the switch from punk_dsp to LifterEngine that enabling true peak also
+// causes; LifterBenchmark --mode=truepeak reports that as costVsLifter.
+template <typename SampleType>
+class TruePeakDetector
+{
+public:
+    // Taps per side of each stage's interpolator
+    static constexpr int stage1Half = 8;
+    static constexpr int stage2Half = 4;
+
+    TruePeakDetector();
+
+    void prepare (int numChannels, int maxBlockSize);
+    void reset();
+
+    // 1 (off), 2 or 4. A change clears the filter state.
+    void setFactor (int newFactor);
+    int getFactor() const noexcept { return factor; }
+    bool isActive() const noexcept { return factor > 1; }
+
+    // Base-rate samples the measurement lags the input by
+    int getLatency() const noexcept { return factor == 4 ? stage1Half + stage2Half / 2 : factor == 2 ? stage1Half : 0; }
+
+    // Measures input channels 0 to numChannels from startSample, for numSamples <= maxBlockSize samples, into getLevels()
+    void process (const juce::dsp::AudioBlock<const SampleType>& input, int startSample, int numChannels, int numSamples) noexcept;
+
+    // Peak magnitude per sample of the last process() call
+    const SampleType* getLevels (int channel) const noexcept { return levels.getReadPointer (channel); }
+
+private:
+    using Vec = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr int lanes = (int) Vec::SIMDNumElements;
+
+    // Histories are written twice, half a buffer apart, so the filter window is always contiguous
+    struct Group
+    {
+        std::array<Vec, 4 * stage1Half> input;
+        std::array<Vec, 4 * stage2Half> upsampled;
+        int inputPosition = 0, upsampledPosition = 0;
+    };
+
+    template <int half>
+    static Vec interpolate (const Vec* window, const std::array<Vec, (size_t) half>& coefficients) noexcept;
+    template <int half>
+    static const Vec* push (std::array<Vec, 4 * half>& history, int& position, Vec value) noexcept;
+
+    std::array<Vec, stage1Half> stage1;
+    std::array<Vec, stage2Half> stage2;
+
+    std::vector<Group> groups;
+    juce::AudioBuffer<SampleType> levels;
+    int factor = 1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TruePeakDetector)
+};
@@ -0,0 +1,107 @@
+#include "WorkerPool.h"
+
+class WorkerPool::Worker : public juce::Thread
+{
+public:
+    explicit Worker (WorkerPool& p) : juce::Thread ("Lifter worker"), pool (p) {}
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            if (auto* batch = pool.takeBatch())
+            {
+                work (*batch);
+                batch->activeWorkers.fetch_sub (1, std::memory_order_release);
+            }
+            else
+            {
+                wait (-1);
+            }
+        }
+    }
+
+private:
+    WorkerPool& pool;
+};
+
+//==============================================================================
+WorkerPool::WorkerPool()
+{
+    // Leave a core for the host
+    const auto numWorkers = juce::jlimit (1, 4, juce::SystemStats::getNumCpus() - 1);
+
+    for (int i = 0; i < numWorkers; ++i)
+        workers.add (new Worker (*this))->startThread();
+}
+
+WorkerPool::~WorkerPool()
+{
+    for (auto* worker : workers)
+    {
+        worker->signalThreadShouldExit();
+        worker->notify();
+    }
+
+    for (auto* worker : workers)
+        worker->stopThread (1000);
+}
+
+void WorkerPool::runAll (TaskFunction task, void* context, int numTasks)
+{
+    if (numTasks <= 0)
+        return;
+
+    Batch batch;
+    batch.task = task;
+    batch.context = context;
+    batch.numTasks = numTasks;
+    batch.remainingTasks = numTasks;
+
+    {
+        const juce::ScopedLock sl (lock);
+        queue.add (&batch);
+    }
+
+    for (auto* worker : workers)
+        worker->notify();
+
+    work (batch);
+    batch.done.wait();
+
+    // The batch lives on this stack, so wait until no worker can still be looking at it
+    {
+        const juce::ScopedLock sl (lock);
+        queue.removeFirstMatchingValue (&batch);
+    }
+
+    while (batch.activeWorkers.load (std::memory_order_acquire) > 0)
+        juce::Thread::yield();
+}
+
+WorkerPool::Batch* WorkerPool::takeBatch()
+{
+    const juce::ScopedLock sl (lock);
+
+    for (auto* batch : queue)
+    {
+        if (batch->nextTask.load (std::memory_order_relaxed) < batch->numTasks)
+        {
+            batch->activeWorkers.fetch_add (1, std::memory_order_relaxed);
+            return batch;
+        }
+    }
+
+    return nullptr;
+}
+
+void WorkerPool::work (Batch& batch)
+{
+    for (auto i = batch.nextTask.fetch_add (1); i < batch.numTasks; i = batch.nextTask.fetch_add (1))
+    {
+        batch.task (batch.context, i);
+
+        if (batch.remainingTasks.fetch_sub (1, std::memory_order_acq_rel) == 1)
+            batch.done.signal();
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+// Small process-wide pool for splitting offline work across cores.
+// Share it with juce::SharedResourcePointer<WorkerPool>.
+//
+// runAll() blocks until every task is done, with the calling thread taking tasks too,
+// so it must not be used from a realtime audio callback.
+class WorkerPool
+{
+public:
+    using TaskFunction = void (*) (void* context, int taskIndex);
+
+    WorkerPool();
+    ~WorkerPool();
+
+    // Runs task (context, i) for every i in [0, numTasks)
+    void runAll (TaskFunction task, void* context, int numTasks);
+
+    int getNumWorkers() const noexcept { return workers.size(); }
+
+private:
+    struct Batch
+    {
+        TaskFunction task;
+        void* context;
+        int numTasks;
+        std::atomic<int> nextTask { 0 }, remainingTasks { 0 }, activeWorkers { 0 };
+        juce::WaitableEvent done;
+    };
+
+    class Worker;
+
+    Batch* takeBatch();
+    static void work (Batch& batch);
+
+    juce::CriticalSection lock;
+    juce::Array<Batch*> queue;
+    juce::OwnedArray<Worker> workers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WorkerPool)
+};
@@ -0,0 +1,389 @@
+// Headless batch renderer: runs WAV/AIFF files through the Lifter on a pool of workers.
+//
+// Usage:
+//   LifterBatch [options] <files or folders...>
+//
+//   --out=<dir>           Output folder, mirroring each input's path below the folder it was found in
+//                         (default: next to each input, with a "_lifter" suffix)
+//   --state=<file>        Load a state blob saved with --save-state or by a host
+//   --save-state=<file>   Write the resulting state blob, and exit if no inputs are given
+//   --<parameterId>=<v>   Any parameter by id, e.g. --ratio=6 --thres=-30 --feed=0
+//   --engine=<name>       "processor" (LifterProcessor, default) or "lifter" (bare punk_dsp::Lifter)
+//   --threads=<n>         Number of workers (default: all cores)
+//   --block=<n>           Processing block size in samples (default: 512)
+//   --sub-block=<n>       Processor sub-block size, 64 to 256 samples (default: 128)
+//   --chunk=<n>           File I/O chunk size in samples (default: 65536)
+//   --trace               Record the applied gain next to each output as <output>.lftt
+//   --trace-every=<n>     Samples per trace record, implies --trace (default: 1)
+//
+// Folders are scanned recursively, skipping earlier "_lifter" outputs. A file whose output would
+// overwrite an input, or the output of another file, fails without being rendered.
+
+#include "PluginProcessor.h"
+#include <juce_audio_formats/juce_audio_formats.h>
+
+#include <iostream>
+#include <set>
+#include <thread>
+
+namespace
+{
+    struct Settings
+    {
+        juce::File outputDir;
+        juce::MemoryBlock state;
+        bool useBareLifter = false;
+        int numThreads = 1;
+        int blockSize = 512;
+        int subBlockSize = Parameters::subBlockDefault;
+        int chunkSize = 65536;
+        int traceEvery = 0;     // 0: no gain trace
+    };
+
+    struct FileResult
+    {
+        juce::File input, root, output;
+        juce::String error;
+        double audioSeconds = 0.0;
+        double wallSeconds = 0.0;
+        juce::int64 traceDropped = 0;
+    };
+
+    constexpr auto outputSuffix = "_lifter";
+
+    // root is the folder the input was found in, or its parent for a file given directly
+    juce::File getOutputFile (const juce::File& input, const juce::File& root, const Settings& settings)
+    {
+        if (settings.outputDir != juce::File())
+            return settings.outputDir.getChildFile (input.getRelativePathFrom (root));
+
+        return input.getSiblingFile (input.getFileNameWithoutExtension() + outputSuffix + input.getFileExtension());
+    }
+
+    // Pushes the processor's current parameter values into a bare Lifter
+    void copyParameters (LifterProcessor& processor, punk_dsp::Lifter& lifter)
+    {
+        auto value = [&processor] (const char* id) { return processor.apvts.getRawParameterValue (id)->load(); };
+
+        lifter.updateRatio (value (Parameters::ratioId));
+        lifter.updateRange (value (Parameters::thresId));
+        lifter.updateKnee (value (Parameters::kneeId));
+        lifter.updateAttack (value (Parameters::attackId));
+        lifter.updateRelease (value (Parameters::releaseId));
+        lifter.updateMakeUp (value (Parameters::makeupId));
+        lifter.updateFeedForward (value (Parameters::feedId) >= 0.5f);
+        lifter.updateMix (value (Parameters::mixId));
+    }
+
+    //==============================================================================
+    // One worker owns one processor and one set of buffers, and renders files until none are left
+    class Worker
+    {
+    public:
+        Worker (const Settings& s, juce::AudioFormatManager& fm)
+            : settings (s), formatManager (fm)
+        {
+            if (settings.state.getSize() > 0)
+                processor.setStateInformation (settings.state.getData(), (int) settings.state.getSize());
+        }
+
+        void render (FileResult& result)
+        {
+            const auto start = juce::Time::getMillisecondCounterHiRes();
+            result.error = renderFile (result);
+
+            // Offline the recorder maps its own segments, so a gap in the trace is a bug, not a slow disk
+            if (result.error.isEmpty() && result.traceDropped > 0)
+                result.error = "gain trace dropped " + juce::String (result.traceDropped) + " records";
+
+            result.wallSeconds = (juce::Time::getMillisecondCounterHiRes() - start) * 0.001;
+        }
+
+    private:
+        juce::String renderFile (FileResult& result)
+        {
+            std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (result.input));
+
+            if (reader == nullptr)
+                return "unsupported or unreadable file";
+
+            const auto numChannels = (int) reader->numChannels;
+            const auto sampleRate = reader->sampleRate;
+
+            if (auto error = prepare (numChannels, sampleRate); error.isNotEmpty())
+                return error;
+
+            auto* format = formatManager.findFormatForFileExtension (result.output.getFileExtension());
+
+            if (format == nullptr)
+                return "no writer for " + result.output.getFileExtension();
+
+            result.output.getParentDirectory().createDirectory();
+            result.output.deleteFile();
+            auto stream = result.output.createOutputStream();
+
+            if (stream == nullptr)
+                return "cannot create " + result.output.getFullPathName();
+
+            std::unique_ptr<juce::AudioFormatWriter> writer (format->createWriterFor (stream.get(), sampleRate, (unsigned int) numChannels, (int) reader->bitsPerSample, reader->metadataValues, 0));
+
+            if (writer == nullptr)
+                return "cannot write this format";
+
+            stream.release(); // The writer owns the stream now
+
+            const auto tracing = settings.traceEvery > 0 && ! settings.useBareLifter;
+            const auto traceFile = result.output.withFileExtension (result.output.getFileExtension() + ".lftt");
+
+            if (tracing && ! processor.startGainTrace (traceFile, settings.traceEvery))
+                return "cannot create " + traceFile.getFullPathName();
+
+            // Stops the trace on every return below, so the file is finished either way
+            const juce::ScopeGuard stopTrace { [this, tracing, &result]
+            {
+                if (! tracing)
+                    return;
+
+                processor.stopGainTrace();
+                result.traceDropped = processor.getGainTraceDropped();
+            } };
+
+            // Stream the file through in large chunks, processing each chunk block by block
+            chunk.setSize (numChannels, settings.chunkSize, false, false, true);
+
+            for (juce::int64 position = 0; position < reader->lengthInSamples; position += settings.chunkSize)
+            {
+                const auto numSamples = (int) juce::jmin ((juce::int64) settings.chunkSize, reader->lengthInSamples - position);
+
+                if (! reader->read (&chunk, 0, numSamples, position, true, true))
+                    return "read error";
+
+                for (int offset = 0; offset < numSamples; offset += settings.blockSize)
+                {
+                    juce::AudioBuffer<float> block (chunk.getArrayOfWritePointers(), numChannels, offset, juce::jmin (settings.blockSize, numSamples - offset));
+
+                    if (settings.useBareLifter)
+                        lifter.process (block);
+                    else
+                        processor.processBlock (block, midi);
+                }
+
+                if (! writer->writeFromAudioSampleBuffer (chunk, 0, numSamples))
+                    return "write error";
+            }
+
+            result.audioSeconds = (double) reader->lengthInSamples / sampleRate;
+            return {};
+        }
+
+        juce::String prepare (int numChannels, double sampleRate)
+        {
+            juce::AudioProcessor::BusesLayout layout;
+            layout.inputBuses.add (juce::AudioChannelSet::canonicalChannelSet (numChannels));
+            layout.outputBuses.add (juce::AudioChannelSet::canonicalChannelSet (numChannels));
+
+            if (! processor.setBusesLayout (layout))
+                return juce::String (numChannels) + " channel layout not supported";
+
+            // A bounce, as hosts flag it: the offline paths (parallel bands, gain trace mapped in line) run
+            processor.setNonRealtime (true);
+            processor.setRateAndBufferSizeDetails (sampleRate, settings.blockSize);
+            processor.setSubBlockSize (settings.subBlockSize);
+            processor.prepareToPlay (sampleRate, settings.blockSize);
+
+            if (settings.useBareLifter)
+            {
+                juce::dsp::ProcessSpec spec;
+                spec.maximumBlockSize = (juce::uint32) settings.blockSize;
+                spec.numChannels = (juce::uint32) numChannels;
+                spec.sampleRate = sampleRate;
+
+                lifter.prepare (spec);
+                copyParameters (processor, lifter);
+            }
+
+            return {};
+        }
+
+        const Settings& settings;
+        juce::AudioFormatManager& formatManager;
+
+        LifterProcessor processor;
+        punk_dsp::Lifter lifter;
+        juce::AudioBuffer<float> chunk;
+        juce::MidiBuffer midi;
+    };
+
+    //==============================================================================
+    void addInputs (const juce::File& file, std::vector<FileResult>& inputs)
+    {
+        if (file.isDirectory())
+        {
+            for (const auto& child : file.findChildFiles (juce::File::findFiles, true, "*.wav;*.aif;*.aiff"))
+                if (! child.getFileNameWithoutExtension().endsWith (outputSuffix))
+                    inputs.push_back ({ child, file });
+        }
+        else if (file.existsAsFile())
+        {
+            inputs.push_back ({ file, file.getParentDirectory() });
+        }
+        else
+        {
+            std::cerr << "Skipping missing input: " << file.getFullPathName() << std::endl;
+        }
+    }
+
+    // Fails any file whose output is an input, or the output of a file before it,
+    // so no two workers ever write the same file and nothing is read after being overwritten
+    void assignOutputs (std::vector<FileResult>& results, const Settings& settings)
+    {
+        std::set<juce::String> inputPaths, outputPaths;
+
+        for (const auto& result : results)
+            inputPaths.insert (result.input.getFullPathName());
+
+        for (auto& result : results)
+        {
+            result.output = getOutputFile (result.input, result.root, settings);
+            const auto path = result.output.getFullPathName();
+
+            if (inputPaths.count (path) > 0)
+                result.error = "output would overwrite an input: " + path;
+            else if (! outputPaths.insert (path).second)
+                result.error = "output would overwrite another file's output: " + path;
+        }
+    }
+
+    bool parseSettings (const juce::ArgumentList& args, Settings& settings, LifterProcessor& defaults)
+    {
+        if (args.containsOption ("--state"))
+        {
+            const auto stateFile = juce::File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption ("--state"));
+
+            if (! stateFile.loadFileAsData (settings.state))
+                return false;
+
+            defaults.setStateInformation (settings.state.getData(), (int) settings.state.getSize());
+        }
+
+        // Individual parameters override whatever the state blob contained
+        for (auto* id : Parameters::ids)
+        {
+            const auto option = "--" + juce::String (id);
+
+            if (args.containsOption (option))
+                if (auto* parameter = defaults.apvts.getParameter (id))
+                    parameter->setValueNotifyingHost (parameter->convertTo0to1 (args.getValueForOption (option).getFloatValue()));
+        }
+
+        settings.state.reset();
+        defaults.getStateInformation (settings.state);
+
+        if (args.containsOption ("--out"))
+        {
+            settings.outputDir = juce::File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption ("--out"));
+            settings.outputDir.createDirectory();
+        }
+
+        settings.useBareLifter = args.getValueForOption ("--engine") == "lifter";
+        settings.numThreads = juce::SystemStats::getNumCpus();
+
+        if (args.containsOption ("--threads"))
+            settings.numThreads = juce::jmax (1, args.getValueForOption ("--threads").getIntValue());
+        if (args.containsOption ("--block"))
+            settings.blockSize = juce::jmax (1, args.getValueForOption ("--block").getIntValue());
+        if (args.containsOption ("--sub-block"))
+            settings.subBlockSize = args.getValueForOption ("--sub-block").getIntValue();
+        if (args.containsOption ("--chunk"))
+            settings.chunkSize = juce::jmax (settings.blockSize, args.getValueForOption ("--chunk").getIntValue());
+        if (args.containsOption ("--trace"))
+            settings.traceEvery = 1;
+        if (args.containsOption ("--trace-every"))
+            settings.traceEvery = juce::jmax (1, args.getValueForOption ("--trace-every").getIntValue());
+
+        return true;
+    }
+
+    void printReport (const std::vector<FileResult>& results, double totalWallSeconds)
+    {
+        double totalAudioSeconds = 0.0;
+        int numFailed = 0;
+
+        for (const auto& result : results)
+        {
+            if (result.error.isNotEmpty())
+            {
+                ++numFailed;
+                std::cout << "FAILED  " << result.input.getFullPathName() << ": " << result.error << std::endl;
+                continue;
+            }
+
+            totalAudioSeconds += result.audioSeconds;
+            std::cout << juce::String (result.audioSeconds / result.wallSeconds, 1).paddedLeft (' ', 8) << "x  "
+                      << result.output.getFullPathName() << std::endl;
+        }
+
+        std::cout << std::endl
+                  << results.size() - (size_t) numFailed << " files, " << numFailed << " failed, "
+                  << juce::String (totalAudioSeconds, 1) << " s of audio in " << juce::String (totalWallSeconds, 2) << " s: "
+                  << juce::String (totalAudioSeconds / juce::jmax (totalWallSeconds, 1.0e-9), 1) << "x realtime" << std::endl;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args (argc, argv);
+
+    Settings settings;
+    LifterProcessor defaults;
+
+    if (! parseSettings (args, settings, defaults))
+    {
+        std::cerr << "Could not read the state file" << std::endl;
+        return 1;
+    }
+
+    if (args.containsOption ("--save-state"))
+        juce::File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption ("--save-state")).replaceWithData (settings.state.getData(), settings.state.getSize());
+
+    // Everything that isn't an option is an input
+    std::vector<FileResult> results;
+
+    for (const auto& arg : args.arguments)
+        if (! arg.isOption())
+            addInputs (arg.resolveAsFile(), results);
+
+    if (results.empty())
+        return args.containsOption ("--save-state") ? 0 : 1;
+
+    assignOutputs (results, settings);
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    // Workers pull the next file index until the list is exhausted
+    std::atomic<size_t> nextFile { 0 };
+    std::vector<std::thread> workers;
+    const auto start = juce::Time::getMillisecondCounterHiRes();
+
+    for (int t = 0; t < juce::jmin (settings.numThreads, (int) results.size()); ++t)
+    {
+        workers.emplace_back ([&] {
+            Worker worker (settings, formatManager);
+
+            for (auto index = nextFile++; index < results.size(); index = nextFile++)
+                if (results[index].error.isEmpty())
+                    worker.render (results[index]);
+        });
+    }
+
+    for (auto& worker : workers)
+        worker.join();
+
+    printReport (results, (juce::Time::getMillisecondCounterHiRes() - start) * 0.001);
+
+    const auto anyFailed = std::any_of (results.begin(), results.end(), [] (const auto& r) { return r.error.isNotEmpty(); });
+    return anyFailed ? 1 : 0;
+}
@@ -0,0 +1,1017 @@
+// Microbenchmarks for LifterProcessor::processBlock and the bare punk_dsp::Lifter.
+//
+// Usage:
+//   LifterBenchmark [--mode=all|processor|lifter|params|curve|simd|link|eco|state|subblock|precision|multiband|cache|startup|truepeak|context] [--seconds=<s>] [--repeats=<n>] [--out=<file.json>]
+//
+// Every case renders the same synthetic signal and reports the median ns/sample and cycles/sample
+// over the repeats. Results are written as JSON so two runs can be diffed between commits.
+// "params" mode times updateParameters() on its own, both with nothing to do and with all parameters touched.
+// "curve" mode compares the LifterEngine gain curve tables against the engine's exact curve, for speed and max error.
+// The error against punk_dsp::Lifter, the reference, is measured by LifterNullTest.
+// "simd" mode null-tests every kernel set this CPU supports against the scalar reference, on the exact curve and on a table, and times it.
+// "link" mode times the engine on 1 to 16 channels with independent and linked detectors.
+// "eco" mode times the engine's control-rate detector for N = 1 to 32 at common block sizes, with the
+// speedup over N = 1 and the peak output difference against it.
+// "subblock" mode times the processor on large host buffers (up to offline bounce sizes) for each sub-block size.
+// "precision" mode times processBlock with float buffers against double buffers, as sent by 64-bit hosts.
+// "multiband" mode times 1 to 6 bands relative to a single band, in realtime and offline (parallel bands).
+// "cache" mode prepares many engines on the same preset, as loading a template would, and reports the
+// cost of the instance that builds the shared curve table against the ones that reuse it.
+// "truepeak" mode times the engine's sidechain-only true-peak detector at 2x and 4x against running the
+// whole engine oversampled through juce::dsp::Oversampling, at 44.1 and 96 kHz, and reads the
+// detector on a quarter-rate sine whose samples fall 3 dB below its true peak. Turning true peak on
+// also moves the plugin's default path from punk_dsp::Lifter to the engine, so the cost of that
+// switch is reported against punk_dsp::Lifter too. How the engine's sound compares with
+// punk_dsp::Lifter's is LifterNullTest's job.
+// "context" mode times the engine at 16 to 128 sample blocks in place, through ProcessContextReplacing and
+// ProcessContextNonReplacing, and on a per-block copy of the input, against punk_dsp::Lifter on the copy.
+// Mix 100 % skips the dry path, mix 50 % shows the cost of it.
+// "startup" mode loads many instances as a session template would, timing each one up to its first
+// processBlock, then opens an editor on each and times it up to its first rendered frame.
+// "state" mode times saving and loading the plugin state, binary against the previous APVTS XML format.
+
+#include "CycleClock.h"
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+#include <iostream>
+
+namespace
+{
+    constexpr std::array blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    constexpr std::array channelCounts { 1, 2 };
+    constexpr std::array sampleRates { 44100.0, 48000.0, 96000.0, 192000.0 };
+    constexpr std::array feedForwardModes { true, false };
+    constexpr std::array mixSettings { 0.0f, 50.0f, 100.0f };
+
+    struct Options
+    {
+        juce::String mode = "all";
+        double seconds = 0.5;
+        int repeats = 5;
+    };
+
+    struct Timing
+    {
+        double nsPerSample = 0.0;
+        double cyclesPerSample = 0.0;
+    };
+
+    // Noise bed with decaying tone bursts every 250 ms, so the Lifter keeps moving between states
+    void fillTestSignal (juce::AudioBuffer<float>& buffer, double sampleRate)
+    {
+        juce::Random random (1234);
+        const auto burstLength = (int) (sampleRate * 0.25);
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            auto* data = buffer.getWritePointer (ch);
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                const auto phase = (float) (i % burstLength) / (float) burstLength;
+                const auto tone = std::sin (juce::MathConstants<float>::twoPi * 220.0f * (float) i / (float) sampleRate);
+                data[i] = 0.01f * (random.nextFloat() * 2.0f - 1.0f) + 0.5f * std::exp (-8.0f * phase) * tone;
+            }
+        }
+    }
+
+    // Runs render() over a fresh copy of the input once per repeat and keeps the median
+    template <typename SampleType, typename RenderFunction>
+    Timing measure (const juce::AudioBuffer<SampleType>& input, juce::AudioBuffer<SampleType>& work, int repeats, RenderFunction&& render)
+    {
+        std::vector<double> ns, cycles;
+        const auto numSamples = (double) input.getNumSamples();
+
+        // First pass warms up caches and branch predictors
+        for (int r = -1; r < repeats; ++r)
+        {
+            work.makeCopyOf (input, true);
+
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+            const auto startCycles = CycleClock::now();
+            render (work);
+            const auto endCycles = CycleClock::now();
+            const auto endTicks = juce::Time::getHighResolutionTicks();
+
+            if (r < 0)
+                continue;
+
+            ns.push_back (juce::Time::highResolutionTicksToSeconds (endTicks - startTicks) * 1.0e9 / numSamples);
+            cycles.push_back ((double) (endCycles - startCycles) / numSamples);
+        }
+
+        std::sort (ns.begin(), ns.end());
+        std::sort (cycles.begin(), cycles.end());
+        return { ns[ns.size() / 2], cycles[cycles.size() / 2] };
+    }
+
+    // Calls process on consecutive non-owning views of the buffer
+    template <typename SampleType, typename ProcessFunction>
+    void processInBlocks (juce::AudioBuffer<SampleType>& buffer, int blockSize, ProcessFunction&& process)
+    {
+        for (int start = 0; start < buffer.getNumSamples(); start += blockSize)
+        {
+            juce::AudioBuffer<SampleType> block (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start, juce::jmin (blockSize, buffer.getNumSamples() - start));
+            process (block);
+        }
+    }
+
+    void setParameter (LifterProcessor& processor, const char* id, float value)
+    {
+        if (auto* parameter = processor.apvts.getParameter (id))
+            parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+    }
+
+    bool prepareProcessor (LifterProcessor& processor, int numChannels, double sampleRate, int blockSize)
+    {
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add (juce::AudioChannelSet::canonicalChannelSet (numChannels));
+        layout.outputBuses.add (juce::AudioChannelSet::canonicalChannelSet (numChannels));
+
+        if (! processor.setBusesLayout (layout))
+            return false;
+
+        processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+        processor.prepareToPlay (sampleRate, blockSize);
+        return true;
+    }
+
+    juce::var makeResult (const juce::String& target, int blockSize, int numChannels, double sampleRate, bool feedForward, float mix, const Timing& timing)
+    {
+        auto* result = new juce::DynamicObject();
+        result->setProperty ("target", target);
+        result->setProperty ("blockSize", blockSize);
+        result->setProperty ("channels", numChannels);
+        result->setProperty ("sampleRate", sampleRate);
+        result->setProperty ("topology", feedForward ? "feed-forward" : "feed-back");
+        result->setProperty ("mix", mix);
+        result->setProperty ("nsPerSample", timing.nsPerSample);
+        result->setProperty ("cyclesPerSample", timing.cyclesPerSample);
+        return result;
+    }
+
+    //==============================================================================
+    void runSweep (const Options& options, bool runProcessor, bool runLifter, juce::Array<juce::var>& results)
+    {
+        juce::AudioBuffer<float> input, work;
+        juce::MidiBuffer midi;
+
+        for (auto sampleRate : sampleRates)
+        {
+            for (auto numChannels : channelCounts)
+            {
+                input.setSize (numChannels, (int) (sampleRate * options.seconds));
+                fillTestSignal (input, sampleRate);
+
+                for (auto blockSize : blockSizes)
+                {
+                    for (auto feedForward : feedForwardModes)
+                    {
+                        for (auto mix : mixSettings)
+                        {
+                            if (runProcessor)
+                            {
+                                LifterProcessor processor;
+                                setParameter (processor, Parameters::feedId, feedForward ? 1.0f : 0.0f);
+                                setParameter (processor, Parameters::mixId, mix);
+
+                                if (prepareProcessor (processor, numChannels, sampleRate, blockSize))
+                                {
+                                    const auto timing = measure (input, work, options.repeats, [&] (auto& buffer) {
+                                        processInBlocks (buffer, blockSize, [&] (auto& block) { processor.processBlock (block, midi); });
+                                    });
+
+                                    results.add (makeResult ("processor", blockSize, numChannels, sampleRate, feedForward, mix, timing));
+                                }
+                            }
+
+                            if (runLifter)
+                            {
+                                punk_dsp::Lifter lifter;
+                                lifter.prepare ({ sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels });
+                                lifter.updateRatio (Parameters::ratioDefault);
+                                lifter.updateRange (Parameters::thresDefault);
+                                lifter.updateKnee (Parameters::kneeDefault);
+                                lifter.updateAttack (Parameters::attackDefault);
+                                lifter.updateRelease (Parameters::releaseDefault);
+                                lifter.updateMakeUp (Parameters::makeupDefault);
+                                lifter.updateFeedForward (feedForward);
+                                lifter.updateMix (mix);
+
+                                const auto timing = measure (input, work, options.repeats, [&] (auto& buffer) {
+                                    processInBlocks (buffer, blockSize, [&] (auto& block) { lifter.process (block); });
+                                });
+
+                                results.add (makeResult ("lifter", blockSize, numChannels, sampleRate, feedForward, mix, timing));
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Times updateParameters() alone. "idle" is the common case of no parameter changes,
+    // "all-changed" touches every parameter before each call (the touching is not timed).
+    void runParameterBenchmark (const Options& options, juce::Array<juce::var>& results)
+    {
+        constexpr int numCalls = 100000;
+
+        LifterProcessor processor;
+        prepareProcessor (processor, 2, 48000.0, 512);
+
+        for (auto allChanged : { false, true })
+        {
+            std::vector<double> ns, cycles;
+
+            for (int r = 0; r < options.repeats; ++r)
+            {
+                juce::int64 ticks = 0;
+                juce::uint64 cycleCount = 0;
+
+                for (int call = 0; call < numCalls; ++call)
+                {
+                    if (allChanged)
+                        for (auto* id : Parameters::ids)
+                            if (auto* parameter = processor.apvts.getParameter (id))
+                                parameter->setValueNotifyingHost ((call & 1) != 0 ? 0.25f : 0.75f);
+
+                    const auto startTicks = juce::Time::getHighResolutionTicks();
+                    const auto startCycles = CycleClock::now();
+                    processor.updateParameters();
+                    cycleCount += CycleClock::now() - startCycles;
+                    ticks += juce::Time::getHighResolutionTicks() - startTicks;
+                }
+
+                ns.push_back (juce::Time::highResolutionTicksToSeconds (ticks) * 1.0e9 / numCalls);
+                cycles.push_back ((double) cycleCount / numCalls);
+            }
+
+            std::sort (ns.begin(), ns.end());
+            std::sort (cycles.begin(), cycles.end());
+
+            auto* result = new juce::DynamicObject();
+            result->setProperty ("target", "updateParameters");
+            result->setProperty ("case", allChanged ? "all-changed" : "idle");
+            result->setProperty ("nsPerCall", ns[ns.size() / 2]);
+            result->setProperty ("cyclesPerCall", cycles[cycles.size() / 2]);
+            results.add (result);
+        }
+    }
+
+    // Max table error against GainCurve::computeGain over a grid of curve settings, and engine speed for each resolution
+    void runCurveBenchmark (const Options& options, juce::Array<juce::var>& results)
+    {
+        constexpr std::array resolutions { GainCurve::Resolution::exact, GainCurve::Resolution::coarse, GainCurve::Resolution::medium, GainCurve::Resolution::fine };
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 512;
+
+        juce::AudioBuffer<float> input (2, (int) (sampleRate * options.seconds)), work;
+        fillTestSignal (input, sampleRate);
+
+        for (auto resolution : resolutions)
+        {
+            auto maxError = 0.0f;
+
+            if (resolution != GainCurve::Resolution::exact)
+            {
+                GainCurve::Table table;
+                table.allocate();
+
+                for (auto thres : { -90.0f, -40.0f, 0.0f })
+                    for (auto ratio : { 1.5f, 4.0f, 100.0f })
+                        for (auto knee : { 1.0f, 12.0f, 30.0f })
+                        {
+                            table.build ({ thres, ratio, knee, 0.0f }, resolution);
+                            maxError = juce::jmax (maxError, GainCurve::measureMaxErrorDb (table));
+                        }
+            }
+
+            LifterEngine engine;
+            engine.setCurveResolution (resolution);
+            engine.prepare ({ sampleRate, (juce::uint32) blockSize, 2 });
+
+            const auto timing = measure (input, work, options.repeats, [&] (auto& buffer) {
+                processInBlocks (buffer, blockSize, [&] (auto& block) { engine.process (block); });
+            });
+
+            auto* result = new juce::DynamicObject();
+            result->setProperty ("target", "engine");
+            result->setProperty ("curve", Parameters::curveChoices[(int) resolution]);
+            result->setProperty ("maxErrorVsExactDb", maxError);
+            result->setProperty ("nsPerSample", timing.nsPerSample);
+            result->setProperty ("cyclesPerSample", timing.cyclesPerSample);
+            results.add (result);
+        }
+    }
+
+    // Renders the same input through each kernel set and reports the largest deviation from scalar
+    void runSimdBenchmark (const Options& options, juce::Array<juce::var>& results)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 512;
+
+        juce::AudioBuffer<float> input (2, (int) (sampleRate * options.seconds)), work, reference;
+        fillTestSignal (input, sampleRate);
+
+        // The exact curve (the default) and a table, each against the scalar set
+        for (auto resolution : { GainCurve::Resolution::exact, GainCurve::Resolution::medium })
+        {
+            for (const auto* kernels : LifterKernels::getAvailable())
+            {
+                LifterEngine engine;
+                engine.setKernels (*kernels);
+                engine.setCurveResolution (resolution);
+                engine.prepare ({ sampleRate, (juce::uint32) blockSize, 2 });
+
+                const auto timing = measure (input, work, options.repeats, [&] (auto& buffer) {
+                    processInBlocks (buffer, blockSize, [&] (auto& block) { engine.process (block); });
+                });
+
+                // A fresh engine renders the null test, so both paths start from the same state
+                LifterEngine nullEngine;
+                nullEngine.setKernels (*kernels);
+                nullEngine.setCurveResolution (resolution);
+                nullEngine.prepare ({ sampleRate, (juce::uint32) blockSize, 2 });
+
+                work.makeCopyOf (input);
+                processInBlocks (work, blockSize, [&] (auto& block) { nullEngine.process (block); });
+
+                if (kernels == &LifterKernels::getScalar())
+                    reference.makeCopyOf (work);
+
+                auto maxDifference = 0.0f;
+                for (int ch = 0; ch < work.getNumChannels(); ++ch)
+                    for (int i = 0; i < work.getNumSamples(); ++i)
+                        maxDifference = juce::jmax (maxDifference, std::abs (work.getSample (ch, i) - reference.getSample (ch, i)));
+
+                auto* result = new juce::DynamicObject();
+                result->setProperty ("target", "engine");
+                result->setProperty ("kernels", kernels->name);
+                result->setProperty ("curve", Parameters::curveChoices[(int) resolution]);
+                result->setProperty ("maxDifferenceDb", juce::Decibels::gainToDecibels (maxDifference, -200.0f));
+                result->setProperty ("nsPerSample", timing.nsPerSample);
+                result->setProperty ("cyclesPerSample", timing.cyclesPerSample);
+                results.add (result);
+            }
+        }
+    }
+
+    // Per-frame cost as channels are added; linked modes should grow slower than per-channel
+    void runLinkBenchmark (const Options& options, juce::Array<juce::var>& results)
+    {
+        constexpr std::array links { LifterEngine::Link::perChannel, LifterEngine::Link::max, LifterEngine::Link::rms };
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 512;
+
+        for (auto numChannels : { 1, 2, 6, 12, 16 })
+        {
+            juce::AudioBuffer<float> input (numChannels, (int) (sampleRate * options.seconds)), work;
+            fillTestSignal (input, sampleRate);
+
+            for (auto link : links)
+            {
+                LifterEngine engine;
+                engine.setLink (link);
+                engine.setCurveResolution (GainCurve::Resolution::medium);
+                engine.prepare ({ sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels });
+
+                const auto timing = measure (input, work, options.repeats, [&] (auto& buffer) {
+                    processInBlocks (buffer, blockSize, [&] (auto& block) { engine.process (block); });
+                });
+
+                // measure() reports per sample frame, which is what matters for scaling
+                auto* result = new juce::DynamicObject();
+                result->setProperty ("target", "engine");
+                result->setProperty ("channels", numChannels);
+                result->setProperty ("link", Parameters::linkChoices[(int) link]);
+                result->setProperty ("nsPerFrame", timing.nsPerSample);
+                result->setProperty ("cyclesPerFrame", timing.cyclesPerSample);
+                results.add (result);
+            }
+        }
+    }
+
+    void runEcoBenchmark (const Options& options, juce::Array<juce::var>& results)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int numChannels = 2;
+        constexpr std::array intervals { 1, 4, 8, 16, 32 };
+
+        juce::AudioBuffer<float> input (numChannels, (int) (sampleRate * options.seconds)), work, reference;
+        fillTestSignal (input, sampleRate);
+
+        for (auto blockSize : { 64, 256, 1024 })
+        {
+            for (auto feedForward : feedForwardModes)
+            {
+                for (auto resolution : { GainCurve::Resolution::exact, GainCurve::Resolution::medium })
+                {
+                    auto baseline = 0.0;
+
+                    for (auto interval : intervals)
+                    {
+                        LifterEngine engine;
+                        engine.updateFeedForward (feedForward);
+                        engine.setCurveResolution (resolution);
+                        engine.setControlInterval (interval);
+                        engine.prepare ({ sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels });
+
+                        const auto timing = measure (input, work, options.repeats, [&] (auto& buffer) {
+                            engine.reset();
+                            processInBlocks (buffer, blockSize, [&] (auto& block) { engine.process (block); });
+                        });
+
+                        // N = 1 comes first and is the reference for both speed and output
+                        if (interval == 1)
+                        {
+                            baseline = timing.nsPerSample;
+                            reference.makeCopyOf (work);
+                        }
+
+                        auto maxDifference = 0.0f;
+                        for (int ch = 0; ch < numChannels; ++ch)
+                            for (int i = 0; i < work.getNumSamples(); ++i)
+                                maxDifference = juce::jmax (maxDifference, std::abs (work.getSample (ch, i) - reference.getSample (ch, i)));
+
+                        auto result = makeResult ("engine", blockSize, numChannels, sampleRate, feedForward, Parameters::mixDefault, timing);
+                        auto* properties = result.getDynamicObject();
+                        properties->setProperty ("curve", Parameters::curveChoices[(int) resolution]);
+                        properties->setProperty ("controlInterval", interval);
+                        properties->setProperty ("speedup", baseline / timing.nsPerSample);
+                        properties->setProperty ("maxDifferenceDb", juce::Decibels::gainToDecibels (maxDifference, -200.0f));
+                        results.add (result);
+                    }
+                }
+            }
+        }
+    }
+
+    void runSubBlockBenchmark (const Options& options, juce::Array<juce::var>& results)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int numChannels = 2;
+        juce::AudioBuffer<float> input (numChannels, (int) (sampleRate * options.seconds)), work;
+        juce::MidiBuffer midi;
+        fillTestSignal (input, sampleRate);
+
+        for (auto blockSize : { 512, 2048, 8192, 16384 })
+        {
+            for (auto feedForward : feedForwardModes)
+            {
+                for (auto subBlockSize : { 64, 128, 256 })
+                {
+                    LifterProcessor processor;
+                    setParameter (processor, Parameters::feedId, feedForward ? 1.0f : 0.0f);
+                    processor.setSubBlockSize (subBlockSize);
+
+                    if (! prepareProcessor (processor, numChannels, sampleRate, blockSize))
+                        continue;
+
+                    const auto timing = measure (input, work, options.repeats, [&] (auto& buffer) {
+                        processInBlocks (buffer, blockSize, [&] (auto& block) { processor.processBlock (block, midi); });
+                    });
+
+                    auto result = makeResult ("processor", blockSize, numChannels, sampleRate, feedForward, Parameters::mixDefault, timing);
+                    result.getDynamicObject()->setProperty ("subBlockSize", subBlockSize);
+                    results.add (result);
+                }
+            }
+        }
+    }
+
+    void runPrecisionBenchmark (const Options& options, juce::Array<juce::var>& results)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int numChannels = 2;
+        const auto numSamples = (int) (sampleRate * options.seconds);
+
+        juce::AudioBuffer<float> input (numChannels, numSamples), work;
+        juce::AudioBuffer<double> doubleInput (numChannels, numSamples), doubleWork;
+        juce::MidiBuffer midi;
+        fillTestSignal (input, sampleRate);
+        doubleInput.makeCopyOf (input);
+
+        for (auto blockSize : { 64, 512, 4096 })
+        {
+            for (auto feedForward : feedForwardModes)
+            {
+                for (auto precision : { juce::AudioProcessor::singlePrecision, juce::AudioProcessor::doublePrecision })
+                {
+                    LifterProcessor processor;
+                    setParameter (processor, Parameters::feedId, feedForward ? 1.0f : 0.0f);
+                    processor.setProcessingPrecision (precision);
+
+                    if (! prepareProcessor (processor, numChannels, sampleRate, blockSize))
+                        continue;
+
+                    const auto isDouble = precision == juce::AudioProcessor::doublePrecision;
+                    const auto timing = isDouble
+                        ? measure (doubleInput, doubleWork, options.repeats, [&] (auto& buffer) {
+                              processInBlocks (buffer, blockSize, [&] (auto& block) { processor.processBlock (block, midi); });
+                          })
+                        : measure (input, work, options.repeats, [&] (auto& buffer) {
+                              processInBlocks (buffer, blockSize, [&] (auto& block) { processor.processBlock (block, midi); });
+                          });
+
+                    auto result = makeResult ("processor", blockSize, numChannels, sampleRate, feedForward, Parameters::mixDefault, timing);
+                    result.getDynamicObject()->setProperty ("precision", isDouble ? "double" : "float");
+                    results.add (result);
+                }
+            }
+        }
+    }
+
+    void runMultibandBenchmark (const Options& options, juce::Array<juce::var>& results)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int numChannels = 2;
+        juce::AudioBuffer<float> input (numChannels, (int) (sampleRate * options.seconds)), work;
+        juce::MidiBuffer midi;
+        fillTestSignal (input, sampleRate);
+
+        for (auto offline : { false, true })
+        {
+            const auto blockSize = offline ? 8192 : 512;
+            auto singleBand = 0.0;
+
+            for (int choice = 0; choice < Parameters::bandsChoices.size(); ++choice)
+            {
+                LifterProcessor processor;
+                setParameter (processor, Parameters::bandsId, (float) choice);
+                setParameter (processor, Parameters::curveId, 2.0f); // Table 32/oct, as a dense session would run
+                processor.setNonRealtime (offline);
+
+                if (! prepareProcessor (processor, numChannels, sampleRate, blockSize))
+                    continue;
+
+                const auto timing = measure (input, work, options.repeats, [&] (auto& buffer) {
+                    processInBlocks (buffer, blockSize, [&] (auto& block) { processor.processBlock (block, midi); });
+                });
+
+                if (choice == 0)
+                    singleBand = timing.nsPerSample;
+
+                auto result = makeResult ("processor", blockSize, numChannels, sampleRate, true, Parameters::mixDefault, timing);
+                result.getDynamicObject()->setProperty ("bands", Parameters::getNumBands (choice));
+                result.getDynamicObject()->setProperty ("offline", offline);
+                result.getDynamicObject()->setProperty ("costVsSingleBand", timing.nsPerSample / singleBand);
+                results.add (result);
+            }
+        }
+    }
+
+    // Cost of preparing engines that share one preset, and the shared table memory that results
+    void runCacheBenchmark (const Options& options, juce::Array<juce::var>& results)
+    {
+        constexpr int numEngines = 200;
+        const juce::dsp::ProcessSpec spec { 48000.0, 512, 2 };
+
+        for (auto resolution : { GainCurve::Resolution::coarse, GainCurve::Resolution::medium, GainCurve::Resolution::fine })
+        {
+            std::vector<double> firstNs, otherNs;
+
+            for (int r = 0; r < options.repeats; ++r)
+            {
+                // A fresh threshold per repeat, so the first instance always misses the cache
+                const auto thres = -40.0f - (float) r * 0.1f - (float) resolution;
+                std::vector<std::unique_ptr<LifterEngine>> engines;
+
+                for (int i = 0; i < numEngines; ++i)
+                {
+                    auto& engine = *engines.emplace_back (std::make_unique<LifterEngine>());
+                    engine.updateRange (thres);
+                    engine.setCurveResolution (resolution);
+
+                    const auto start = juce::Time::getHighResolutionTicks();
+                    engine.prepare (spec);
+                    const auto ns = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1.0e9;
+
+                    (i == 0 ? firstNs : otherNs).push_back (ns);
+                }
+            }
+
+            std::sort (firstNs.begin(), firstNs.end());
+            std::sort (otherNs.begin(), otherNs.end());
+
+            auto* result = new juce::DynamicObject();
+            result->setProperty ("target", "curveCache");
+            result->setProperty ("curve", Parameters::curveChoices[(int) resolution]);
+            result->setProperty ("engines", numEngines);
+            result->setProperty ("nsPrepareBuilding", firstNs[firstNs.size() / 2]);
+            result->setProperty ("nsPrepareShared", otherNs[otherNs.size() / 2]);
+            // Before the cache every engine kept three tables sized for the finest resolution
+            const auto tableBytes = [] (GainCurve::Resolution r) { return (GainCurve::Table::getNumEntries (GainCurve::getBitsPerOctave (r)) + 1) * (int) sizeof (float); };
+            result->setProperty ("sharedTableBytes", tableBytes (resolution));
+            result->setProperty ("perEngineTableBytesWithoutCache", 3 * tableBytes (GainCurve::Resolution::fine));
+            result->setProperty ("cachedTables", juce::SharedResourcePointer<CurveCache>()->getStats().numTables);
+            results.add (result);
+        }
+    }
+
+    // Sidechain oversampling against whole-path oversampling, and what each factor reads on inter-sample peaks
+    void runTruePeakBenchmark (const Options& options, juce::Array<juce::var>& results)
+    {
+        constexpr int numChannels = 2;
+        constexpr int blockSize = 512;
+
+        for (auto sampleRate : { 44100.0, 96000.0 })
+        {
+            juce::AudioBuffer<float> input (numChannels, (int) (sampleRate * options.seconds)), work;
+            fillTestSignal (input, sampleRate);
+
+            // Same settings on every variant, punk_dsp::Lifter included
+            auto configure = [] (auto& dsp)
+            {
+                dsp.updateRatio (Parameters::ratioDefault);
+                dsp.updateRange (Parameters::thresDefault);
+                dsp.updateKnee (Parameters::kneeDefault);
+                dsp.updateAttack (Parameters::attackDefault);
+                dsp.updateRelease (Parameters::releaseDefault);
+                dsp.updateMakeUp (Parameters::makeupDefault);
+                dsp.updateMix (Parameters::mixDefault);
+            };
+
+            auto timeEngine = [&] (int truePeakFactor)
+            {
+                LifterEngine engine;
+                configure (engine);
+                engine.setTruePeakFactor (truePeakFactor);
+                engine.prepare ({ sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels });
+
+                return measure (input, work, options.repeats, [&] (auto& buffer) {
+                    processInBlocks (buffer, blockSize, [&] (auto& block) { engine.process (block); });
+                });
+            };
+
+            // The whole engine at the oversampled rate, between the upsampling and downsampling filters
+            auto timeFullPath = [&] (int factor)
+            {
+                const auto stages = factor == 4 ? 2 : 1;
+                juce::dsp::Oversampling<float> oversampling ((size_t) numChannels, (size_t) stages, juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, false);
+                oversampling.initProcessing ((size_t) blockSize);
+
+                LifterEngine engine;
+                configure (engine);
+                engine.prepare ({ sampleRate * factor, (juce::uint32) (blockSize * factor), (juce::uint32) numChannels });
+
+                return measure (input, work, options.repeats, [&] (auto& buffer) {
+                    processInBlocks (buffer, blockSize, [&] (auto& block) {
+                        juce::dsp::AudioBlock<float> audioBlock (block);
+                        auto upsampled = oversampling.processSamplesUp (audioBlock);
+
+                        std::array<float*, numChannels> channels { upsampled.getChannelPointer (0), upsampled.getChannelPointer (1) };
+                        juce::AudioBuffer<float> view (channels.data(), numChannels, (int) upsampled.getNumSamples());
+                        engine.process (view);
+
+                        oversampling.processSamplesDown (audioBlock);
+                    });
+                });
+            };
+
+            // Quarter-rate sine at 45 degrees: every sample sits at 0.707 of the true peak
+            auto readPeakDb = [&] (int factor)
+            {
+                constexpr int length = 4096;
+                juce::AudioBuffer<float> sine (1, length);
+
+                for (int i = 0; i < length; ++i)
+                    sine.setSample (0, i, std::sin (juce::MathConstants<float>::halfPi * (float) i + juce::MathConstants<float>::pi * 0.25f));
+
+                if (factor == 1)
+                    return juce::Decibels::gainToDecibels (sine.getMagnitude (0, length));
+
+                TruePeakDetector<float> detector;
+                detector.prepare (1, length);
+                detector.setFactor (factor);
+                detector.process (juce::dsp::AudioBlock<const float> (sine), 0, 1, length);
+
+                const auto* levels = detector.getLevels (0);
+                return juce::Decibels::gainToDecibels (*std::max_element (levels + length / 2, levels + length));
+            };
+
+            // What the plugin runs with true peak off
+            auto timeLifter = [&]
+            {
+                punk_dsp::Lifter lifter;
+                lifter.prepare ({ sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels });
+                configure (lifter);
+
+                return measure (input, work, options.repeats, [&] (auto& buffer) {
+                    processInBlocks (buffer, blockSize, [&] (auto& block) { lifter.process (block); });
+                });
+            };
+
+            const auto lifter = timeLifter();
+            const auto samplePeak = timeEngine (1);
+
+            for (auto factor : { 2, 4 })
+            {
+                const auto sidechainOnly = timeEngine (factor);
+                const auto fullPath = timeFullPath (factor);
+
+                auto* result = new juce::DynamicObject();
+                result->setProperty ("target", "truePeak");
+                result->setProperty ("sampleRate", sampleRate);
+                result->setProperty ("channels", numChannels);
+                result->setProperty ("blockSize", blockSize);
+                result->setProperty ("factor", factor);
+                result->setProperty ("nsPerSampleLifter", lifter.nsPerSample);
+                result->setProperty ("nsPerSampleSamplePeak", samplePeak.nsPerSample);
+                result->setProperty ("nsPerSampleSidechainOnly", sidechainOnly.nsPerSample);
+                result->setProperty ("nsPerSampleFullPath", fullPath.nsPerSample);
+                result->setProperty ("addedCostVsFullPath", (sidechainOnly.nsPerSample - samplePeak.nsPerSample)
+                                                            / juce::jmax (1.0e-9, fullPath.nsPerSample - samplePeak.nsPerSample));
+                result->setProperty ("costVsLifter", sidechainOnly.nsPerSample / juce::jmax (1.0e-9, lifter.nsPerSample));
+                result->setProperty ("samplePeakReadingDb", readPeakDb (1));
+                result->setProperty ("truePeakReadingDb", readPeakDb (factor));
+                results.add (result);
+            }
+        }
+    }
+
+    // Small host blocks, where the per-call overhead shows. The engine runs in place, through both
+    // juce::dsp contexts and, as an out-of-place host without the context API would use it, on a
+    // copy of the input. punk_dsp::Lifter only runs in place, so it is timed on the copy.
+    void runContextBenchmark (const Options& options, juce::Array<juce::var>& results)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int numChannels = 2;
+
+        juce::AudioBuffer<float> input (numChannels, (int) (sampleRate * options.seconds)), work;
+        fillTestSignal (input, sampleRate);
+
+        for (auto blockSize : { 16, 32, 64, 128 })
+        {
+            for (auto mix : { 50.0f, 100.0f })
+            {
+                punk_dsp::Lifter lifter;
+                lifter.prepare ({ sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels });
+
+                LifterEngine engine;
+                engine.prepare ({ sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels });
+
+                // Same settings on both
+                auto configure = [mix] (auto& dsp)
+                {
+                    dsp.updateRatio (Parameters::ratioDefault);
+                    dsp.updateRange (Parameters::thresDefault);
+                    dsp.updateKnee (Parameters::kneeDefault);
+                    dsp.updateAttack (Parameters::attackDefault);
+                    dsp.updateRelease (Parameters::releaseDefault);
+                    dsp.updateMakeUp (Parameters::makeupDefault);
+                    dsp.updateMix (mix);
+                };
+
+                configure (lifter);
+                configure (engine);
+
+                // process (start, length, output) on consecutive blocks; output starts as a copy of the input
+                auto timeBlocks = [&] (auto&& process)
+                {
+                    return measure (input, work, options.repeats, [&] (auto& output) {
+                        for (int start = 0; start < output.getNumSamples(); start += blockSize)
+                            process (start, juce::jmin (blockSize, output.getNumSamples() - start), output);
+                    });
+                };
+
+                auto copyInput = [&] (int start, int length, juce::AudioBuffer<float>& output)
+                {
+                    for (int ch = 0; ch < numChannels; ++ch)
+                        output.copyFrom (ch, start, input, ch, start, length);
+
+                    return juce::AudioBuffer<float> (output.getArrayOfWritePointers(), numChannels, start, length);
+                };
+
+                const auto lifterCopy = timeBlocks ([&] (int start, int length, auto& output) {
+                    auto view = copyInput (start, length, output);
+                    lifter.process (view);
+                });
+
+                const auto engineCopy = timeBlocks ([&] (int start, int length, auto& output) {
+                    auto view = copyInput (start, length, output);
+                    engine.process (view);
+                });
+
+                const auto inPlace = timeBlocks ([&] (int start, int length, auto& output) {
+                    juce::AudioBuffer<float> view (output.getArrayOfWritePointers(), numChannels, start, length);
+                    engine.process (view);
+                });
+
+                const auto replacing = timeBlocks ([&] (int start, int length, auto& output) {
+                    auto block = juce::dsp::AudioBlock<float> (output).getSubBlock ((size_t) start, (size_t) length);
+                    engine.process (juce::dsp::ProcessContextReplacing<float> (block));
+                });
+
+                const auto nonReplacing = timeBlocks ([&] (int start, int length, auto& output) {
+                    auto block = juce::dsp::AudioBlock<float> (output).getSubBlock ((size_t) start, (size_t) length);
+                    engine.process (juce::dsp::ProcessContextNonReplacing<float> (juce::dsp::AudioBlock<const float> (input).getSubBlock ((size_t) start, (size_t) length), block));
+                });
+
+                auto add = [&] (const char* target, const char* context, const Timing& timing)
+                {
+                    auto result = makeResult (target, blockSize, numChannels, sampleRate, true, mix, timing);
+                    auto* properties = result.getDynamicObject();
+                    properties->setProperty ("context", context);
+                    properties->setProperty ("speedupVsLifter", lifterCopy.nsPerSample / timing.nsPerSample);
+                    results.add (result);
+                };
+
+                add ("lifter", "copy, in place", lifterCopy);
+                add ("engine", "copy, in place", engineCopy);
+                add ("engine", "in place", inPlace);
+                add ("engine", "replacing", replacing);
+                add ("engine", "non-replacing", nonReplacing);
+            }
+        }
+    }
+
+    // Instantiation and editor open times across a session's worth of instances. The first
+    // instance and editor pay for the process-wide resources, so they are reported on their own.
+    void runStartupBenchmark (const Options& options, juce::Array<juce::var>& results)
+    {
+        constexpr int numInstances = 200;
+        constexpr int blockSize = 512;
+
+        auto elapsedNs = [] (juce::int64 start) { return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1.0e9; };
+        auto median = [] (std::vector<double>& values) { std::sort (values.begin(), values.end()); return values[values.size() / 2]; };
+
+        std::vector<double> firstProcessNs, processNs, firstEditorNs, editorNs, totalProcessNs, totalEditorNs;
+
+        for (int r = 0; r < options.repeats; ++r)
+        {
+            std::vector<std::unique_ptr<LifterProcessor>> processors;
+            std::vector<std::unique_ptr<juce::AudioProcessorEditor>> editors;
+            juce::AudioBuffer<float> block (2, blockSize);
+            juce::MidiBuffer midi;
+
+            const auto sessionStart = juce::Time::getHighResolutionTicks();
+
+            for (int i = 0; i < numInstances; ++i)
+            {
+                const auto start = juce::Time::getHighResolutionTicks();
+                auto& processor = *processors.emplace_back (std::make_unique<LifterProcessor>());
+                prepareProcessor (processor, 2, 48000.0, blockSize);
+                block.clear();
+                processor.processBlock (block, midi);
+
+                (i == 0 && r == 0 ? firstProcessNs : processNs).push_back (elapsedNs (start));
+            }
+
+            totalProcessNs.push_back (elapsedNs (sessionStart));
+            const auto editorsStart = juce::Time::getHighResolutionTicks();
+
+            // Without a window, the first frame is rendered into an image, as a peer would paint it
+            for (int i = 0; i < numInstances; ++i)
+            {
+                const auto start = juce::Time::getHighResolutionTicks();
+                auto& editor = editors.emplace_back (processors[(size_t) i]->createEditorIfNeeded());
+                editor->setVisible (true);
+                juce::ignoreUnused (editor->createComponentSnapshot (editor->getLocalBounds()));
+
+                (i == 0 && r == 0 ? firstEditorNs : editorNs).push_back (elapsedNs (start));
+            }
+
+            totalEditorNs.push_back (elapsedNs (editorsStart));
+
+            // Editors go before their processors, as in a host
+            editors.clear();
+        }
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty ("target", "startup");
+        result->setProperty ("instances", numInstances);
+        result->setProperty ("parameters", (int) Parameters::count);
+        result->setProperty ("nsToFirstProcessBlockFirstInstance", firstProcessNs.front());
+        result->setProperty ("nsToFirstProcessBlock", median (processNs));
+        result->setProperty ("nsToEditorVisibleFirstEditor", firstEditorNs.front());
+        result->setProperty ("nsToEditorVisible", median (editorNs));
+        result->setProperty ("msSessionLoad", median (totalProcessNs) * 1.0e-6);
+        result->setProperty ("msOpenAllEditors", median (totalEditorNs) * 1.0e-6);
+        results.add (result);
+    }
+
+    // Save and load times per call, and blob sizes, for the binary state and the old XML one
+    void runStateBenchmark (const Options& options, juce::Array<juce::var>& results)
+    {
+        constexpr int numCalls = 10000;
+        LifterProcessor processor;
+
+        auto timeCalls = [&] (auto&& call)
+        {
+            std::vector<double> ns;
+
+            for (int r = 0; r < options.repeats; ++r)
+            {
+                const auto start = juce::Time::getHighResolutionTicks();
+                for (int i = 0; i < numCalls; ++i)
+                    call();
+                ns.push_back (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1.0e9 / numCalls);
+            }
+
+            std::sort (ns.begin(), ns.end());
+            return ns[ns.size() / 2];
+        };
+
+        juce::MemoryBlock binary, xml;
+        processor.getStateInformation (binary);
+        if (auto element = processor.apvts.copyState().createXml())
+            juce::AudioProcessor::copyXmlToBinary (*element, xml);
+
+        auto addResult = [&] (const char* format, const juce::MemoryBlock& blob, double saveNs)
+        {
+            const auto loadNs = timeCalls ([&] { processor.setStateInformation (blob.getData(), (int) blob.getSize()); });
+
+            auto* result = new juce::DynamicObject();
+            result->setProperty ("target", "state");
+            result->setProperty ("format", format);
+            result->setProperty ("bytes", (int) blob.getSize());
+            result->setProperty ("nsPerSave", saveNs);
+            result->setProperty ("nsPerLoad", loadNs);
+            results.add (result);
+        };
+
+        addResult ("binary", binary, timeCalls ([&] { processor.getStateInformation (binary); }));
+        addResult ("xml", xml, timeCalls ([&] {
+            if (auto element = processor.apvts.copyState().createXml())
+                juce::AudioProcessor::copyXmlToBinary (*element, xml);
+        }));
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args (argc, argv);
+
+    Options options;
+    if (args.containsOption ("--mode"))
+        options.mode = args.getValueForOption ("--mode");
+    if (args.containsOption ("--seconds"))
+        options.seconds = juce::jmax (0.01, args.getValueForOption ("--seconds").getDoubleValue());
+    if (args.containsOption ("--repeats"))
+        options.repeats = juce::jmax (1, args.getValueForOption ("--repeats").getIntValue());
+
+    const auto all = options.mode == "all";
+    juce::Array<juce::var> results;
+
+    if (all || options.mode == "processor" || options.mode == "lifter")
+        runSweep (options, all || options.mode == "processor", all || options.mode == "lifter", results);
+
+    if (all || options.mode == "params")
+        runParameterBenchmark (options, results);
+
+    if (all || options.mode == "curve")
+        runCurveBenchmark (options, results);
+
+    if (all || options.mode == "simd")
+        runSimdBenchmark (options, results);
+
+    if (all || options.mode == "link")
+        runLinkBenchmark (options, results);
+
+    if (all || options.mode == "eco")
+        runEcoBenchmark (options, results);
+
+    if (all || options.mode == "subblock")
+        runSubBlockBenchmark (options, results);
+
+    if (all || options.mode == "precision")
+        runPrecisionBenchmark (options, results);
+
+    if (all || options.mode == "multiband")
+        runMultibandBenchmark (options, results);
+
+    if (all || options.mode == "cache")
+        runCacheBenchmark (options, results);
+
+    if (all || options.mode == "truepeak")
+        runTruePeakBenchmark (options, results);
+
+    if (all || options.mode == "context")
+        runContextBenchmark (options, results);
+
+    if (all || options.mode == "startup")
+        runStartupBenchmark (options, results);
+
+    if (all || options.mode == "state")
+        runStateBenchmark (options, results);
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty ("cpu", juce::SystemStats::getCpuModel());
+    report->setProperty ("cycleCounter", CycleClock::getName());
+    report->setProperty ("seconds", options.seconds);
+    report->setProperty ("repeats", options.repeats);
+    report->setProperty ("results", results);
+
+    const auto json = juce::JSON::toString (juce::var (report));
+
+    if (args.containsOption ("--out"))
+        juce::File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption ("--out")).replaceWithText (json);
+    else
+        std::cout << json << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,529 @@
+// Parameter-grid characterisation of punk_dsp::Lifter, for tuning presets without a DAW.
+//
+// Usage:
+//   LifterCharacterize [options]
+//
+//   --thres=<values>      Grid axes, each a comma list ("2,4,8") or an inclusive range "start:end:step".
+//   --ratio=<values>      Defaults: thres -60:-20:10, ratio 2,4,8,16, knee 1,6,12,24,
+//   --knee=<values>                 attack 1,5,15,50, release 20,60,200,1000, feed 0,1, mix 50,100
+//   --attack=<values>               (5120 points)
+//   --release=<values>
+//   --feed=<values>
+//   --mix=<values>
+//   --rate=<hz>           Sample rate of the step and burst tests (default: 48000)
+//   --step=<low>,<high>   Step test levels in dBFS (default: -70,-10)
+//   --trace-seconds=<s>   Length of the burst test (default: 2)
+//   --trace-block=<n>     Samples per gain addition reading in the burst test (default: 64)
+//   --threads=<n>         Number of workers (default: all cores)
+//   --out=<file>          Output file (default: lifter_grid.lftc)
+//
+// Every grid point gets three measurements, each from a freshly prepared Lifter:
+//   curve     Static input/output curve. DC is held at each of 31 levels from -90 to 0 dBFS until
+//             the gain has settled, and the output level is read. The curve does not depend on the
+//             rate, so it runs at 4 kHz, where settling takes a twelfth of the samples.
+//   step      Step response with DC between the two --step levels. Attack is timed after the step
+//             up in level (gain coming down) and release after the step down (gain going back up),
+//             to 63 % and 90 % of the gain change. NaN when the step does not move the gain.
+//   trace     Gain addition read every --trace-block samples over noise with decaying tone bursts.
+//
+// Workers each own one Lifter and buffers sized once for the whole grid, and take grid points
+// from a shared counter. Finished rows are streamed to the output in row groups while the
+// workers carry on, so memory stays bounded whatever the grid size.
+//
+// Output format (.lftc), little-endian:
+//   "LftC" magic, uint32 version 1, uint32 metadata size, metadata: UTF-8 JSON with the settings,
+//   the curve input levels and the column list (name and values per row, in file order).
+//   Then row groups until the end of the file: uint32 row count, then each column in turn,
+//   rows x values float32.
+//
+// Reading it with numpy:
+//   f = open ("lifter_grid.lftc", "rb"); f.read (8); meta = json.loads (f.read (struct.unpack ("<I", f.read (4))[0]))
+//   while (header := f.read (4)):
+//       rows = struct.unpack ("<I", header)[0]
+//       group = { c["name"]: numpy.fromfile (f, "<f4", rows * c["width"]).reshape (rows, c["width"]) for c in meta["columns"] }
+
+#include "PluginProcessor.h"
+
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    constexpr juce::uint32 magic = 0x43746c4c; // "LftC"
+    constexpr juce::uint32 version = 1;
+
+    constexpr double curveRate = 4000.0;
+    constexpr float curveMinDb = -90.0f;
+    constexpr float curveStepDb = 3.0f;
+    constexpr int numCurvePoints = 31;
+
+    constexpr int blockSize = 512;
+    constexpr int rowsPerGroup = 256;
+    constexpr int groupsInFlight = 4;
+
+    enum Axis { thres, ratio, knee, attack, release, feed, mix, numAxes };
+    constexpr std::array<const char*, numAxes> axisNames { "thres", "ratio", "knee", "attack", "release", "feed", "mix" };
+    constexpr std::array<const char*, numAxes> axisDefaults { "-60:-20:10", "2,4,8,16", "1,6,12,24", "1,5,15,50", "20,60,200,1000", "0,1", "50,100" };
+
+    struct Options
+    {
+        std::array<std::vector<float>, numAxes> axes;
+        double sampleRate = 48000.0;
+        float stepLowDb = -70.0f, stepHighDb = -10.0f;
+        double traceSeconds = 2.0;
+        int traceBlock = 64;
+        int numThreads = 1;
+        juce::File outputFile;
+
+        juce::int64 getNumPoints() const
+        {
+            juce::int64 points = 1;
+            for (const auto& values : axes)
+                points *= (juce::int64) values.size();
+            return points;
+        }
+
+        int getNumTraceReadings() const { return juce::jmax (1, (int) (traceSeconds * sampleRate) / traceBlock); }
+    };
+
+    struct Column
+    {
+        juce::String name;
+        int width = 1, offset = 0;
+    };
+
+    // Row layout, the same for every grid point
+    std::vector<Column> makeColumns (const Options& options)
+    {
+        std::vector<Column> columns;
+
+        for (auto* name : axisNames)
+            columns.push_back ({ name, 1 });
+
+        for (auto* name : { "attack63Ms", "attack90Ms", "release63Ms", "release90Ms" })
+            columns.push_back ({ name, 1 });
+
+        columns.push_back ({ "curveOutputDb", numCurvePoints });
+        columns.push_back ({ "traceGainDb", options.getNumTraceReadings() });
+
+        auto offset = 0;
+        for (auto& column : columns)
+        {
+            column.offset = offset;
+            offset += column.width;
+        }
+
+        return columns;
+    }
+
+    // "a,b,c" or "start:end:step", end included
+    std::vector<float> parseAxis (const juce::String& text)
+    {
+        std::vector<float> values;
+
+        if (text.containsChar (':'))
+        {
+            const auto parts = juce::StringArray::fromTokens (text, ":", {});
+            const auto start = parts[0].getFloatValue(), end = parts[1].getFloatValue();
+            const auto step = std::abs (parts[2].getFloatValue());
+
+            if (step > 0.0f)
+                for (auto v = start; start <= end ? v <= end + step * 1.0e-3f : v >= end - step * 1.0e-3f; v += start <= end ? step : -step)
+                    values.push_back (v);
+        }
+        else
+        {
+            for (const auto& token : juce::StringArray::fromTokens (text, ",", {}))
+                if (token.trim().isNotEmpty())
+                    values.push_back (token.getFloatValue());
+        }
+
+        return values;
+    }
+
+    // Noise bed with decaying tone bursts every 250 ms, the same material as the other tools
+    void fillTestSignal (juce::AudioBuffer<float>& buffer, double sampleRate)
+    {
+        juce::Random random (1234);
+        const auto burstLength = (int) (sampleRate * 0.25);
+        auto* data = buffer.getWritePointer (0);
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        {
+            const auto phase = (float) (i % burstLength) / (float) burstLength;
+            const auto tone = std::sin (juce::MathConstants<float>::twoPi * 220.0f * (float) i / (float) sampleRate);
+            data[i] = 0.01f * (random.nextFloat() * 2.0f - 1.0f) + 0.5f * std::exp (-8.0f * phase) * tone;
+        }
+    }
+
+    //==============================================================================
+    // Rows are written into a few groups of slots. A worker waits only if it gets more than
+    // groupsInFlight groups ahead of the writer, and the writer waits for each group to fill.
+    class RowStore
+    {
+    public:
+        RowStore (juce::int64 rows, int width)
+            : numRows (rows), rowWidth (width), slots ((size_t) (groupsInFlight * rowsPerGroup * width))
+        {
+        }
+
+        float* beginRow (juce::int64 row)
+        {
+            const auto group = row / rowsPerGroup;
+
+            std::unique_lock<std::mutex> lock (mutex);
+            changed.wait (lock, [&] { return group < groupsWritten + groupsInFlight; });
+
+            return getRow (row);
+        }
+
+        void endRow (juce::int64 row)
+        {
+            const std::lock_guard<std::mutex> lock (mutex);
+            ++completed[(size_t) ((row / rowsPerGroup) % groupsInFlight)];
+            changed.notify_all();
+        }
+
+        // Writer thread: calls write (firstRow, numRows) for each group in order, once it is complete
+        template <typename WriteFunction>
+        void drain (WriteFunction&& write)
+        {
+            for (juce::int64 first = 0; first < numRows; first += rowsPerGroup)
+            {
+                const auto rows = (int) juce::jmin ((juce::int64) rowsPerGroup, numRows - first);
+                auto& count = completed[(size_t) ((first / rowsPerGroup) % groupsInFlight)];
+
+                {
+                    std::unique_lock<std::mutex> lock (mutex);
+                    changed.wait (lock, [&] { return count == rows; });
+                }
+
+                write (first, rows);
+
+                const std::lock_guard<std::mutex> lock (mutex);
+                count = 0;
+                ++groupsWritten;
+                changed.notify_all();
+            }
+        }
+
+        const float* getRow (juce::int64 row) const { return slots.data() + (size_t) (row % (groupsInFlight * rowsPerGroup)) * (size_t) rowWidth; }
+        float* getRow (juce::int64 row) { return slots.data() + (size_t) (row % (groupsInFlight * rowsPerGroup)) * (size_t) rowWidth; }
+
+    private:
+        const juce::int64 numRows;
+        const int rowWidth;
+        std::vector<float> slots;
+        std::array<int, groupsInFlight> completed {};
+        juce::int64 groupsWritten = 0;
+        std::mutex mutex;
+        std::condition_variable changed;
+    };
+
+    //==============================================================================
+    // One Lifter and one set of buffers, reused for every grid point the worker takes
+    class Worker
+    {
+    public:
+        Worker (const Options& o, const std::vector<Column>& c, const juce::AudioBuffer<float>& bursts)
+            : options (o), columns (c), burstSignal (bursts)
+        {
+            block.setSize (1, blockSize);
+
+            // The longest step response in the grid, so no run ever needs more
+            const auto maxRelease = *std::max_element (options.axes[release].begin(), options.axes[release].end());
+            const auto maxAttack = *std::max_element (options.axes[attack].begin(), options.axes[attack].end());
+            gainTrajectory.resize ((size_t) getSettleSamples (juce::jmax (maxAttack, maxRelease), options.sampleRate));
+        }
+
+        void measure (juce::int64 point, float* row)
+        {
+            // Mixed radix over the axes, last axis fastest
+            auto remainder = point;
+            for (int a = numAxes - 1; a >= 0; --a)
+            {
+                const auto& values = options.axes[(size_t) a];
+                settings[(size_t) a] = values[(size_t) (remainder % (juce::int64) values.size())];
+                remainder /= (juce::int64) values.size();
+            }
+
+            for (int a = 0; a < numAxes; ++a)
+                row[columns[(size_t) a].offset] = settings[(size_t) a];
+
+            measureSteps (row + columns[numAxes].offset);
+            measureCurve (row + columns[numAxes + 4].offset);
+            measureTrace (row + columns[numAxes + 5].offset);
+        }
+
+    private:
+        static int getSettleSamples (float timeMs, double sampleRate)
+        {
+            return juce::jmax (blockSize, (int) std::ceil (Parameters::settleTimeConstants * timeMs * 0.001 * sampleRate));
+        }
+
+        void prepareLifter (double sampleRate)
+        {
+            lifter.prepare ({ sampleRate, (juce::uint32) blockSize, 1 });
+            lifter.updateRange (settings[thres]);
+            lifter.updateRatio (settings[ratio]);
+            lifter.updateKnee (settings[knee]);
+            lifter.updateAttack (settings[attack]);
+            lifter.updateRelease (settings[release]);
+            lifter.updateMakeUp (0.0f);
+            lifter.updateFeedForward (settings[feed] >= 0.5f);
+            lifter.updateMix (settings[mix]);
+        }
+
+        // Holds DC at level for numSamples, writing the per-sample gain into gains if given.
+        // Returns the gain at the last sample.
+        float holdLevel (float level, int numSamples, float* gains = nullptr)
+        {
+            auto lastGain = 1.0f;
+
+            for (int start = 0; start < numSamples; start += blockSize)
+            {
+                const auto length = juce::jmin (blockSize, numSamples - start);
+                juce::AudioBuffer<float> view (block.getArrayOfWritePointers(), 1, 0, length);
+
+                juce::FloatVectorOperations::fill (view.getWritePointer (0), level, length);
+                lifter.process (view);
+
+                const auto* out = view.getReadPointer (0);
+
+                if (gains != nullptr)
+                    juce::FloatVectorOperations::multiply (gains + start, out, 1.0f / level, length);
+
+                lastGain = out[length - 1] / level;
+            }
+
+            return lastGain;
+        }
+
+        // Samples until the gain has covered fraction of the way from before to after, in ms
+        float crossingMs (const float* gains, int numSamples, float before, float after, float fraction) const
+        {
+            if (std::abs (after - before) < 1.0e-4f * juce::jmax (std::abs (before), 1.0e-6f))
+                return std::numeric_limits<float>::quiet_NaN();
+
+            const auto target = before + fraction * (after - before);
+            const auto rising = after > before;
+
+            for (int i = 0; i < numSamples; ++i)
+                if (rising ? gains[i] >= target : gains[i] <= target)
+                    return (float) (1000.0 * (i + 1) / options.sampleRate);
+
+            return std::numeric_limits<float>::quiet_NaN();
+        }
+
+        void measureSteps (float* out)
+        {
+            prepareLifter (options.sampleRate);
+
+            const auto low = juce::Decibels::decibelsToGain (options.stepLowDb);
+            const auto high = juce::Decibels::decibelsToGain (options.stepHighDb);
+            const auto settle = getSettleSamples (juce::jmax (settings[attack], settings[release]), options.sampleRate);
+            auto* gains = gainTrajectory.data();
+
+            const auto lowGain = holdLevel (low, settle);
+
+            const auto highGain = holdLevel (high, settle, gains);
+            out[0] = crossingMs (gains, settle, lowGain, highGain, 0.63f);
+            out[1] = crossingMs (gains, settle, lowGain, highGain, 0.9f);
+
+            const auto backGain = holdLevel (low, settle, gains);
+            out[2] = crossingMs (gains, settle, highGain, backGain, 0.63f);
+            out[3] = crossingMs (gains, settle, highGain, backGain, 0.9f);
+        }
+
+        void measureCurve (float* out)
+        {
+            prepareLifter (curveRate);
+            const auto settle = getSettleSamples (juce::jmax (settings[attack], settings[release]), curveRate);
+
+            for (int p = 0; p < numCurvePoints; ++p)
+            {
+                const auto inputDb = curveMinDb + curveStepDb * (float) p;
+                out[p] = inputDb + juce::Decibels::gainToDecibels (holdLevel (juce::Decibels::decibelsToGain (inputDb), settle));
+            }
+        }
+
+        void measureTrace (float* out)
+        {
+            prepareLifter (options.sampleRate);
+
+            for (int r = 0; r < options.getNumTraceReadings(); ++r)
+            {
+                auto* data = block.getWritePointer (0);
+                juce::FloatVectorOperations::copy (data, burstSignal.getReadPointer (0, r * options.traceBlock), options.traceBlock);
+
+                juce::AudioBuffer<float> view (block.getArrayOfWritePointers(), 1, 0, options.traceBlock);
+                lifter.process (view);
+                out[r] = lifter.getGainAddition();
+            }
+        }
+
+        const Options& options;
+        const std::vector<Column>& columns;
+        const juce::AudioBuffer<float>& burstSignal;
+
+        punk_dsp::Lifter lifter;
+        std::array<float, numAxes> settings {};
+        juce::AudioBuffer<float> block;
+        std::vector<float> gainTrajectory;
+    };
+
+    //==============================================================================
+    bool parseOptions (const juce::ArgumentList& args, Options& options)
+    {
+        for (size_t a = 0; a < numAxes; ++a)
+        {
+            const auto option = "--" + juce::String (axisNames[a]);
+            options.axes[a] = parseAxis (args.containsOption (option) ? args.getValueForOption (option) : juce::String (axisDefaults[a]));
+
+            if (options.axes[a].empty())
+            {
+                std::cerr << "No values for " << option << std::endl;
+                return false;
+            }
+        }
+
+        options.numThreads = juce::SystemStats::getNumCpus();
+        options.outputFile = juce::File::getCurrentWorkingDirectory().getChildFile ("lifter_grid.lftc");
+
+        if (args.containsOption ("--rate"))
+            options.sampleRate = juce::jmax (8000.0, args.getValueForOption ("--rate").getDoubleValue());
+        if (args.containsOption ("--trace-seconds"))
+            options.traceSeconds = juce::jmax (0.01, args.getValueForOption ("--trace-seconds").getDoubleValue());
+        if (args.containsOption ("--trace-block"))
+            options.traceBlock = juce::jlimit (1, blockSize, args.getValueForOption ("--trace-block").getIntValue());
+        if (args.containsOption ("--threads"))
+            options.numThreads = juce::jmax (1, args.getValueForOption ("--threads").getIntValue());
+        if (args.containsOption ("--out"))
+            options.outputFile = juce::File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption ("--out"));
+
+        if (args.containsOption ("--step"))
+        {
+            const auto levels = parseAxis (args.getValueForOption ("--step"));
+
+            if (levels.size() != 2 || levels[0] >= levels[1])
+            {
+                std::cerr << "--step takes two levels, low first" << std::endl;
+                return false;
+            }
+
+            options.stepLowDb = levels[0];
+            options.stepHighDb = levels[1];
+        }
+
+        return true;
+    }
+
+    juce::String makeMetadata (const Options& options, const std::vector<Column>& columns)
+    {
+        auto* meta = new juce::DynamicObject();
+        meta->setProperty ("points", options.getNumPoints());
+        meta->setProperty ("sampleRate", options.sampleRate);
+        meta->setProperty ("curveSampleRate", curveRate);
+        meta->setProperty ("stepLowDb", options.stepLowDb);
+        meta->setProperty ("stepHighDb", options.stepHighDb);
+        meta->setProperty ("traceSeconds", options.traceSeconds);
+        meta->setProperty ("traceBlock", options.traceBlock);
+
+        juce::Array<juce::var> curveInputs, columnList;
+
+        for (int p = 0; p < numCurvePoints; ++p)
+            curveInputs.add (curveMinDb + curveStepDb * (float) p);
+
+        for (const auto& column : columns)
+        {
+            auto* entry = new juce::DynamicObject();
+            entry->setProperty ("name", column.name);
+            entry->setProperty ("width", column.width);
+            columnList.add (entry);
+        }
+
+        meta->setProperty ("curveInputDb", curveInputs);
+        meta->setProperty ("columns", columnList);
+        return juce::JSON::toString (juce::var (meta), true);
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args (argc, argv);
+
+    Options options;
+    if (! parseOptions (args, options))
+        return 1;
+
+    const auto columns = makeColumns (options);
+    const auto rowWidth = columns.back().offset + columns.back().width;
+    const auto numPoints = options.getNumPoints();
+
+    options.outputFile.deleteFile();
+    juce::FileOutputStream out (options.outputFile);
+
+    if (! out.openedOk())
+    {
+        std::cerr << "Cannot create " << options.outputFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    const auto metadata = makeMetadata (options, columns);
+    out.writeInt ((int) magic);
+    out.writeInt ((int) version);
+    out.writeInt ((int) metadata.getNumBytesAsUTF8());
+    out.write (metadata.toRawUTF8(), metadata.getNumBytesAsUTF8());
+
+    juce::AudioBuffer<float> bursts (1, options.getNumTraceReadings() * options.traceBlock);
+    fillTestSignal (bursts, options.sampleRate);
+
+    std::cout << numPoints << " grid points on " << options.numThreads << " threads" << std::endl;
+
+    RowStore store (numPoints, rowWidth);
+    std::atomic<juce::int64> nextPoint { 0 };
+    std::vector<std::thread> workers;
+    const auto start = juce::Time::getMillisecondCounterHiRes();
+
+    for (int t = 0; t < (int) juce::jmin ((juce::int64) options.numThreads, numPoints); ++t)
+    {
+        workers.emplace_back ([&] {
+            Worker worker (options, columns, bursts);
+
+            for (auto point = nextPoint++; point < numPoints; point = nextPoint++)
+            {
+                worker.measure (point, store.beginRow (point));
+                store.endRow (point);
+            }
+        });
+    }
+
+    // Columnar row groups: each column's values for every row of the group, then the next column
+    store.drain ([&] (juce::int64 firstRow, int rows)
+    {
+        out.writeInt (rows);
+
+        for (const auto& column : columns)
+            for (int r = 0; r < rows; ++r)
+                out.write (store.getRow (firstRow + r) + column.offset, sizeof (float) * (size_t) column.width);
+
+        std::cerr << "\r" << firstRow + rows << " / " << numPoints << std::flush;
+    });
+
+    for (auto& worker : workers)
+        worker.join();
+
+    out.flush();
+
+    const auto seconds = (juce::Time::getMillisecondCounterHiRes() - start) * 0.001;
+    std::cerr << std::endl;
+    std::cout << numPoints << " points in " << juce::String (seconds, 1) << " s ("
+              << juce::String ((double) numPoints / juce::jmax (seconds, 1.0e-9), 1) << " points/s), "
+              << options.outputFile.getFullPathName() << std::endl;
+
+    return out.getStatus().wasOk() ? 0 : 1;
+}
@@ -0,0 +1,400 @@
+// Many-instance host simulation: drives hundreds of LifterProcessors from realtime worker threads
+// at a fixed callback period, the way a DAW graph does, while automating their parameters.
+//
+// Usage:
+//   LifterHostStress [options]
+//
+//   --instances=<n>       Number of processors in the session (default: 200)
+//   --threads=<n>         Largest worker count, runs 1, 2, 4 ... up to it (default: all cores)
+//   --block=<n>           Callback size in samples (default: 256)
+//   --rate=<hz>           Sample rate (default: 48000)
+//   --channels=<n>        Channels per instance (default: 2)
+//   --seconds=<s>         Session time simulated for each worker count (default: 5)
+//   --automation=<n>      Parameter changes per instance per second (default: 20)
+//   --<parameterId>=<v>   Starting value for every instance, e.g. --curve=2 --bands=3
+//   --out=<file.json>     Also write the results as JSON
+//
+// Every instance has its own buffers and its own settings, so the workers touch as much memory
+// as a real session and single-instance effects (cache thrashing, false sharing) show up.
+// Instances are dealt round-robin, so neighbours in memory run on different workers.
+//
+// A cycle misses its deadline when any worker finishes it after the next callback is due.
+// Load is a worker's processing time over the period. Speedup compares the slowest worker
+// of each cycle against the one-thread run, and efficiency is speedup over the thread count.
+// Workers ask for realtime priority; on Linux that needs rtprio rights, and the report says
+// when it fell back to a normal high priority thread.
+
+#include "PluginProcessor.h"
+
+#include <iostream>
+#include <numeric>
+
+namespace
+{
+    // Parameters the automation moves. Topology choices (bands, eco, curve) stay where they
+    // were set, since a session changes those by hand rather than from automation lanes.
+    constexpr std::array automatedIds { Parameters::ratioId, Parameters::thresId, Parameters::kneeId, Parameters::attackId,
+                                        Parameters::releaseId, Parameters::makeupId, Parameters::feedId, Parameters::mixId };
+
+    struct Options
+    {
+        int numInstances = 200;
+        int maxThreads = 1;
+        int blockSize = 256;
+        double sampleRate = 48000.0;
+        int numChannels = 2;
+        double seconds = 5.0;
+        double automationRate = 20.0;
+        juce::File outputFile;
+    };
+
+    struct Instance
+    {
+        std::unique_ptr<LifterProcessor> processor;
+        juce::AudioBuffer<float> buffer;
+        std::array<juce::RangedAudioParameter*, automatedIds.size()> parameters {};
+        int sourceOffset = 0;
+    };
+
+    // Noise bed with decaying tone bursts every 250 ms, so the instances keep moving between states
+    void fillTestSignal (juce::AudioBuffer<float>& buffer, double sampleRate)
+    {
+        juce::Random random (1234);
+        const auto burstLength = (int) (sampleRate * 0.25);
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            auto* data = buffer.getWritePointer (ch);
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                const auto phase = (float) (i % burstLength) / (float) burstLength;
+                const auto tone = std::sin (juce::MathConstants<float>::twoPi * 220.0f * (float) i / (float) sampleRate);
+                data[i] = 0.01f * (random.nextFloat() * 2.0f - 1.0f) + 0.5f * std::exp (-8.0f * phase) * tone;
+            }
+        }
+    }
+
+    //==============================================================================
+    // Stands in for one of the host's audio threads: every period it renders its share of the session
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker (int index, const Options& o, const juce::AudioBuffer<float>& s, juce::int64 start, juce::int64 period, int cycles)
+            : juce::Thread ("Lifter host worker " + juce::String (index)),
+              options (o), source (s), startTicks (start), periodTicks (period), numCycles (cycles),
+              automationChance (o.automationRate * (double) o.blockSize / o.sampleRate),
+              random (index + 1)
+        {
+            // Per-cycle results are preallocated, so recording them does not disturb the run
+            busyTicks.resize ((size_t) numCycles);
+            finishTicks.resize ((size_t) numCycles);
+        }
+
+        void addInstance (Instance& instance) { instances.push_back (&instance); }
+
+        // Returns false if the thread had to fall back to a non-realtime priority
+        bool launch()
+        {
+            if (startRealtimeThread (juce::Thread::RealtimeOptions{}.withApproximateAudioProcessingTime (options.blockSize, options.sampleRate)))
+                return true;
+
+            startThread (juce::Thread::Priority::highest);
+            return false;
+        }
+
+        void run() override
+        {
+            for (int cycle = 0; cycle < numCycles && ! threadShouldExit(); ++cycle)
+            {
+                waitUntil (startTicks + cycle * periodTicks);
+
+                const auto begin = juce::Time::getHighResolutionTicks();
+
+                for (auto* instance : instances)
+                    render (*instance, cycle);
+
+                const auto end = juce::Time::getHighResolutionTicks();
+                busyTicks[(size_t) cycle] = end - begin;
+                finishTicks[(size_t) cycle] = end;
+            }
+        }
+
+        std::vector<juce::int64> busyTicks, finishTicks;
+
+    private:
+        void render (Instance& instance, int cycle)
+        {
+            // Automation arrives the way the plugin wrappers deliver it: set, then notify, on the audio thread
+            if (random.nextDouble() < automationChance)
+            {
+                auto* parameter = instance.parameters[(size_t) random.nextInt ((int) instance.parameters.size())];
+                const auto value = random.nextFloat();
+                parameter->setValue (value);
+                parameter->sendValueChangedMessageToListeners (value);
+            }
+
+            const auto numSamples = options.blockSize;
+            const auto position = (instance.sourceOffset + cycle * numSamples) % (source.getNumSamples() - numSamples);
+
+            for (int ch = 0; ch < instance.buffer.getNumChannels(); ++ch)
+                instance.buffer.copyFrom (ch, 0, source, ch % source.getNumChannels(), position, numSamples);
+
+            instance.processor->processBlock (instance.buffer, midi);
+        }
+
+        // Sleeps while there is time to spare and yields for the last stretch, so a cycle starts on time
+        static void waitUntil (juce::int64 ticks)
+        {
+            const auto spinTicks = juce::Time::secondsToHighResolutionTicks (0.002);
+
+            for (auto remaining = ticks - juce::Time::getHighResolutionTicks(); remaining > 0;
+                 remaining = ticks - juce::Time::getHighResolutionTicks())
+            {
+                if (remaining > spinTicks)
+                    juce::Thread::sleep (1);
+                else
+                    juce::Thread::yield();
+            }
+        }
+
+        const Options& options;
+        const juce::AudioBuffer<float>& source;
+        const juce::int64 startTicks, periodTicks;
+        const int numCycles;
+        const double automationChance;
+
+        std::vector<Instance*> instances;
+        juce::Random random;
+        juce::MidiBuffer midi;
+    };
+
+    //==============================================================================
+    struct RunResult
+    {
+        int numThreads = 0;
+        bool realtime = true;
+        int numCycles = 0, deadlineMisses = 0;
+        double meanCriticalPathUs = 0.0, meanCpuPerCycleUs = 0.0;
+        std::vector<double> meanLoad, maxLoad;
+    };
+
+    RunResult runSession (std::vector<Instance>& instances, const juce::AudioBuffer<float>& source, const Options& options, int numThreads)
+    {
+        const auto periodSeconds = (double) options.blockSize / options.sampleRate;
+        const auto periodTicks = juce::Time::secondsToHighResolutionTicks (periodSeconds);
+        const auto numCycles = juce::jmax (1, (int) (options.seconds / periodSeconds));
+
+        // Leave the workers time to start before the first callback is due
+        const auto startTicks = juce::Time::getHighResolutionTicks() + juce::Time::secondsToHighResolutionTicks (0.1);
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        for (int t = 0; t < numThreads; ++t)
+            workers.push_back (std::make_unique<Worker> (t, options, source, startTicks, periodTicks, numCycles));
+
+        for (size_t i = 0; i < instances.size(); ++i)
+            workers[i % (size_t) numThreads]->addInstance (instances[i]);
+
+        RunResult result;
+        result.numThreads = numThreads;
+        result.numCycles = numCycles;
+
+        for (auto& worker : workers)
+            result.realtime = worker->launch() && result.realtime;
+
+        for (auto& worker : workers)
+            worker->waitForThreadToExit (-1);
+
+        for (int cycle = 0; cycle < numCycles; ++cycle)
+        {
+            const auto deadline = startTicks + (cycle + 1) * periodTicks;
+            juce::int64 lastFinish = 0, criticalPath = 0, cpu = 0;
+
+            for (auto& worker : workers)
+            {
+                lastFinish = juce::jmax (lastFinish, worker->finishTicks[(size_t) cycle]);
+                criticalPath = juce::jmax (criticalPath, worker->busyTicks[(size_t) cycle]);
+                cpu += worker->busyTicks[(size_t) cycle];
+            }
+
+            if (lastFinish > deadline)
+                ++result.deadlineMisses;
+
+            result.meanCriticalPathUs += juce::Time::highResolutionTicksToSeconds (criticalPath) * 1.0e6 / numCycles;
+            result.meanCpuPerCycleUs += juce::Time::highResolutionTicksToSeconds (cpu) * 1.0e6 / numCycles;
+        }
+
+        for (auto& worker : workers)
+        {
+            const auto& busy = worker->busyTicks;
+            const auto total = std::accumulate (busy.begin(), busy.end(), (juce::int64) 0);
+            const auto peak = *std::max_element (busy.begin(), busy.end());
+
+            result.meanLoad.push_back ((double) total / (double) numCycles / (double) periodTicks);
+            result.maxLoad.push_back ((double) peak / (double) periodTicks);
+        }
+
+        return result;
+    }
+
+    //==============================================================================
+    void parseOptions (const juce::ArgumentList& args, Options& options)
+    {
+        options.maxThreads = juce::SystemStats::getNumCpus();
+
+        if (args.containsOption ("--instances"))
+            options.numInstances = juce::jmax (1, args.getValueForOption ("--instances").getIntValue());
+        if (args.containsOption ("--threads"))
+            options.maxThreads = juce::jmax (1, args.getValueForOption ("--threads").getIntValue());
+        if (args.containsOption ("--block"))
+            options.blockSize = juce::jmax (1, args.getValueForOption ("--block").getIntValue());
+        if (args.containsOption ("--rate"))
+            options.sampleRate = juce::jmax (8000.0, args.getValueForOption ("--rate").getDoubleValue());
+        if (args.containsOption ("--channels"))
+            options.numChannels = juce::jlimit (1, Parameters::maxChannels, args.getValueForOption ("--channels").getIntValue());
+        if (args.containsOption ("--seconds"))
+            options.seconds = juce::jmax (0.1, args.getValueForOption ("--seconds").getDoubleValue());
+        if (args.containsOption ("--automation"))
+            options.automationRate = juce::jmax (0.0, args.getValueForOption ("--automation").getDoubleValue());
+        if (args.containsOption ("--out"))
+            options.outputFile = juce::File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption ("--out"));
+    }
+
+    bool createSession (const juce::ArgumentList& args, const Options& options, std::vector<Instance>& instances)
+    {
+        juce::Random random (42);
+        instances.resize ((size_t) options.numInstances);
+
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add (juce::AudioChannelSet::canonicalChannelSet (options.numChannels));
+        layout.outputBuses.add (juce::AudioChannelSet::canonicalChannelSet (options.numChannels));
+
+        for (auto& instance : instances)
+        {
+            instance.processor = std::make_unique<LifterProcessor>();
+            auto& processor = *instance.processor;
+
+            // Every instance starts from its own settings, as the tracks of a session would
+            for (size_t p = 0; p < automatedIds.size(); ++p)
+            {
+                instance.parameters[p] = processor.apvts.getParameter (automatedIds[p]);
+                instance.parameters[p]->setValueNotifyingHost (random.nextFloat());
+            }
+
+            for (auto* id : Parameters::ids)
+                if (const auto option = "--" + juce::String (id); args.containsOption (option))
+                    if (auto* parameter = processor.apvts.getParameter (id))
+                        parameter->setValueNotifyingHost (parameter->convertTo0to1 (args.getValueForOption (option).getFloatValue()));
+
+            if (! processor.setBusesLayout (layout))
+                return false;
+
+            processor.setRateAndBufferSizeDetails (options.sampleRate, options.blockSize);
+            processor.prepareToPlay (options.sampleRate, options.blockSize);
+
+            instance.buffer.setSize (options.numChannels, options.blockSize);
+            instance.sourceOffset = random.nextInt ((int) options.sampleRate);
+        }
+
+        return true;
+    }
+
+    void printResult (const RunResult& result, const RunResult& oneThread)
+    {
+        const auto speedup = oneThread.meanCriticalPathUs / juce::jmax (result.meanCriticalPathUs, 1.0e-9);
+        const auto percent = [] (double v) { return juce::String (v * 100.0, 1) + "%"; };
+
+        std::cout << juce::String (result.numThreads).paddedLeft (' ', 3) << " threads"
+                  << (result.realtime ? "" : " (not realtime)") << ": "
+                  << result.deadlineMisses << "/" << result.numCycles << " deadlines missed, "
+                  << "slowest worker " << juce::String (result.meanCriticalPathUs, 1) << " us/cycle, "
+                  << "speedup " << juce::String (speedup, 2) << "x, "
+                  << "efficiency " << percent (speedup / result.numThreads) << std::endl;
+
+        for (size_t t = 0; t < result.meanLoad.size(); ++t)
+            std::cout << "      worker " << juce::String ((int) t).paddedLeft (' ', 2) << ": load "
+                      << percent (result.meanLoad[t]) << " mean, " << percent (result.maxLoad[t]) << " max" << std::endl;
+    }
+
+    juce::var toJson (const RunResult& result, const RunResult& oneThread, const Options& options)
+    {
+        const auto speedup = oneThread.meanCriticalPathUs / juce::jmax (result.meanCriticalPathUs, 1.0e-9);
+
+        juce::Array<juce::var> workers;
+        for (size_t t = 0; t < result.meanLoad.size(); ++t)
+        {
+            auto* worker = new juce::DynamicObject();
+            worker->setProperty ("meanLoad", result.meanLoad[t]);
+            worker->setProperty ("maxLoad", result.maxLoad[t]);
+            workers.add (worker);
+        }
+
+        auto* object = new juce::DynamicObject();
+        object->setProperty ("instances", options.numInstances);
+        object->setProperty ("threads", result.numThreads);
+        object->setProperty ("realtime", result.realtime);
+        object->setProperty ("blockSize", options.blockSize);
+        object->setProperty ("sampleRate", options.sampleRate);
+        object->setProperty ("cycles", result.numCycles);
+        object->setProperty ("deadlineMisses", result.deadlineMisses);
+        object->setProperty ("criticalPathUs", result.meanCriticalPathUs);
+        object->setProperty ("cpuPerCycleUs", result.meanCpuPerCycleUs);
+        object->setProperty ("speedup", speedup);
+        object->setProperty ("efficiency", speedup / result.numThreads);
+        object->setProperty ("workers", workers);
+        return object;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args (argc, argv);
+
+    Options options;
+    parseOptions (args, options);
+
+    std::vector<Instance> instances;
+
+    if (! createSession (args, options, instances))
+    {
+        std::cerr << options.numChannels << " channel layout not supported" << std::endl;
+        return 1;
+    }
+
+    // One second of source material, read by each instance from its own offset
+    juce::AudioBuffer<float> source (options.numChannels, (int) options.sampleRate + options.blockSize);
+    fillTestSignal (source, options.sampleRate);
+
+    std::cout << options.numInstances << " instances, " << options.numChannels << " channels, "
+              << options.blockSize << " samples at " << options.sampleRate << " Hz ("
+              << juce::String (1000.0 * options.blockSize / options.sampleRate, 2) << " ms period)" << std::endl;
+
+    std::vector<RunResult> results;
+
+    for (int numThreads = 1;; numThreads = juce::jmin (numThreads * 2, options.maxThreads))
+    {
+        results.push_back (runSession (instances, source, options, numThreads));
+        printResult (results.back(), results.front());
+
+        if (numThreads == options.maxThreads)
+            break;
+    }
+
+    if (options.outputFile != juce::File())
+    {
+        juce::Array<juce::var> runs;
+        for (const auto& result : results)
+            runs.add (toJson (result, results.front(), options));
+
+        auto* report = new juce::DynamicObject();
+        report->setProperty ("cpu", juce::SystemStats::getCpuModel());
+        report->setProperty ("cores", juce::SystemStats::getNumCpus());
+        report->setProperty ("results", runs);
+
+        options.outputFile.replaceWithText (juce::JSON::toString (juce::var (report)));
+    }
+
+    return 0;
+}
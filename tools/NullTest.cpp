@@ -0,0 +1,269 @@
+// Null test of LifterEngine against punk_dsp::Lifter, the reference the plugin's default path runs.
+//
+// Usage:
+//   LifterNullTest [--seconds=<s>] [--rate=<hz>] [--verbose]
+//
+//   --seconds=<s>   Length of the dynamic test signal per grid point (default: 0.5)
+//   --rate=<hz>     Sample rate of the dynamic test (default: 48000)
+//   --verbose       Print every grid point, not only the failures
+//
+// The processor swaps LifterEngine in for punk_dsp::Lifter whenever one of its modes is on
+// (curve table, linked detector, eco, true peak, multiband, more than two channels). With all of
+// those off, the engine has to sound the same as punk_dsp::Lifter. Two checks, over a grid of
+// threshold, ratio, knee, attack, release, makeup, topology and mix:
+//
+//   static    DC held at every level from -90 to 0 dBFS in 1 dB steps until both have settled.
+//             The exact engine must match punk_dsp::Lifter's output level within 0.05 dB.
+//             The engine's curve tables are measured the same way and reported, not checked:
+//             that is their error against the reference, not against the engine's own curve.
+//   dynamic   Stereo noise with decaying tone bursts. Wherever the input is above -80 dBFS,
+//             the exact engine's output must be within 0.1 dB of punk_dsp::Lifter's.
+//
+// Linked detectors, eco and true peak measure the signal differently by design, so they are
+// not part of the null test; their difference to the reference is the feature.
+//
+// Exits with 1 if any grid point is outside the tolerance.
+
+#include "PluginProcessor.h"
+
+#include <iostream>
+
+namespace
+{
+    constexpr float staticToleranceDb = 0.05f;
+    constexpr float dynamicToleranceDb = 0.1f;
+
+    // Levels below this are not compared in the dynamic test, the gain ratio there is mostly noise
+    constexpr float dynamicFloorDb = -80.0f;
+
+    // The static curve does not depend on the rate, a low one settles in fewer samples
+    constexpr double staticRate = 4000.0;
+    constexpr int blockSize = 512;
+
+    struct Point
+    {
+        float thres, ratio, knee, attack, release, makeup, mix;
+        bool feedForward;
+
+        juce::String toString() const
+        {
+            return "thres " + juce::String (thres) + ", ratio " + juce::String (ratio) + ", knee " + juce::String (knee)
+                 + ", attack " + juce::String (attack) + ", release " + juce::String (release) + ", makeup " + juce::String (makeup)
+                 + ", mix " + juce::String (mix) + (feedForward ? ", feed-forward" : ", feed-back");
+        }
+    };
+
+    template <typename Dsp>
+    void configure (Dsp& dsp, const Point& point)
+    {
+        dsp.updateRatio (point.ratio);
+        dsp.updateRange (point.thres);
+        dsp.updateKnee (point.knee);
+        dsp.updateAttack (point.attack);
+        dsp.updateRelease (point.release);
+        dsp.updateMakeUp (point.makeup);
+        dsp.updateFeedForward (point.feedForward);
+        dsp.updateMix (point.mix);
+    }
+
+    // Settings first, so the engine builds its table for them while preparing
+    template <typename Dsp>
+    void prepare (Dsp& dsp, const Point& point, double sampleRate, int numChannels)
+    {
+        configure (dsp, point);
+        dsp.prepare ({ sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels });
+        configure (dsp, point);
+    }
+
+    // Noise bed with decaying tone bursts every 250 ms, the same material as the other tools
+    void fillTestSignal (juce::AudioBuffer<float>& buffer, double sampleRate)
+    {
+        juce::Random random (1234);
+        const auto burstLength = (int) (sampleRate * 0.25);
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            auto* data = buffer.getWritePointer (ch);
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                const auto phase = (float) (i % burstLength) / (float) burstLength;
+                const auto tone = std::sin (juce::MathConstants<float>::twoPi * 220.0f * (float) i / (float) sampleRate);
+                data[i] = 0.01f * (random.nextFloat() * 2.0f - 1.0f) + 0.5f * std::exp (-8.0f * phase) * tone;
+            }
+        }
+    }
+
+    template <typename Dsp>
+    void render (Dsp& dsp, juce::AudioBuffer<float>& buffer)
+    {
+        for (int start = 0; start < buffer.getNumSamples(); start += blockSize)
+        {
+            juce::AudioBuffer<float> block (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start, juce::jmin (blockSize, buffer.getNumSamples() - start));
+            dsp.process (block);
+        }
+    }
+
+    // Output level in dBFS for DC held at each level from -90 to 0 dBFS until settled
+    template <typename Dsp>
+    std::vector<float> measureStaticCurve (Dsp& dsp, const Point& point, juce::AudioBuffer<float>& scratch)
+    {
+        const auto settleSamples = juce::jmax (blockSize, (int) std::ceil (Parameters::settleTimeConstants * juce::jmax (point.attack, point.release) * 0.001 * staticRate));
+        std::vector<float> curve;
+
+        prepare (dsp, point, staticRate, 1);
+
+        for (int levelDb = -90; levelDb <= 0; ++levelDb)
+        {
+            const auto level = juce::Decibels::decibelsToGain ((float) levelDb);
+            auto last = 0.0f;
+
+            for (int done = 0; done < settleSamples; done += blockSize)
+            {
+                juce::FloatVectorOperations::fill (scratch.getWritePointer (0), level, blockSize);
+                dsp.process (scratch);
+                last = scratch.getSample (0, blockSize - 1);
+            }
+
+            curve.push_back (juce::Decibels::gainToDecibels (last, -200.0f));
+        }
+
+        return curve;
+    }
+
+    float maxDifferenceDb (const std::vector<float>& a, const std::vector<float>& b)
+    {
+        auto difference = 0.0f;
+
+        for (size_t i = 0; i < a.size(); ++i)
+            difference = juce::jmax (difference, std::abs (a[i] - b[i]));
+
+        return difference;
+    }
+
+    // Largest output difference in dB wherever the input is above dynamicFloorDb
+    float maxGainDifferenceDb (const juce::AudioBuffer<float>& input, const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+    {
+        const auto floor = juce::Decibels::decibelsToGain (dynamicFloorDb);
+        auto difference = 0.0f;
+
+        for (int ch = 0; ch < input.getNumChannels(); ++ch)
+        {
+            for (int i = 0; i < input.getNumSamples(); ++i)
+            {
+                if (std::abs (input.getSample (ch, i)) < floor)
+                    continue;
+
+                const auto ratio = std::abs (a.getSample (ch, i)) / juce::jmax (std::abs (b.getSample (ch, i)), 1.0e-20f);
+                difference = juce::jmax (difference, std::abs (juce::Decibels::gainToDecibels (ratio, -200.0f)));
+            }
+        }
+
+        return difference;
+    }
+
+    std::vector<Point> makeGrid (bool staticOnly)
+    {
+        std::vector<Point> grid;
+
+        // The static curve does not depend on the ballistics or the mix, fast settings settle sooner
+        const auto attacks = staticOnly ? std::vector<float> { 1.0f } : std::vector<float> { 1.0f, 15.0f, 100.0f };
+        const auto releases = staticOnly ? std::vector<float> { 20.0f } : std::vector<float> { 20.0f, 200.0f, 1000.0f };
+        const auto mixes = staticOnly ? std::vector<float> { 100.0f } : std::vector<float> { 50.0f, 100.0f };
+
+        for (auto thres : { -60.0f, -40.0f, -20.0f })
+            for (auto ratio : { 1.5f, 4.0f, 20.0f })
+                for (auto knee : { 1.0f, 12.0f, 30.0f })
+                    for (auto attack : attacks)
+                        for (auto release : releases)
+                            for (auto makeup : { 0.0f, 6.0f })
+                                for (auto mix : mixes)
+                                    for (auto feedForward : { true, false })
+                                        grid.push_back ({ thres, ratio, knee, attack, release, makeup, mix, feedForward });
+
+        return grid;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args (argc, argv);
+
+    const auto seconds = args.containsOption ("--seconds") ? juce::jmax (0.05, args.getValueForOption ("--seconds").getDoubleValue()) : 0.5;
+    const auto sampleRate = args.containsOption ("--rate") ? juce::jmax (8000.0, args.getValueForOption ("--rate").getDoubleValue()) : 48000.0;
+    const auto verbose = args.containsOption ("--verbose");
+
+    constexpr std::array resolutions { GainCurve::Resolution::exact, GainCurve::Resolution::coarse, GainCurve::Resolution::medium, GainCurve::Resolution::fine };
+    std::array<float, resolutions.size()> staticErrors {};
+    auto staticFailures = 0, dynamicFailures = 0;
+    auto worstDynamic = 0.0f;
+
+    // Static curve, exact engine and every table resolution against the reference
+    {
+        juce::AudioBuffer<float> scratch (1, blockSize);
+
+        for (const auto& point : makeGrid (true))
+        {
+            punk_dsp::Lifter lifter;
+            const auto reference = measureStaticCurve (lifter, point, scratch);
+
+            for (size_t r = 0; r < resolutions.size(); ++r)
+            {
+                LifterEngine engine;
+                engine.setCurveResolution (resolutions[r]);
+                const auto error = maxDifferenceDb (measureStaticCurve (engine, point, scratch), reference);
+                staticErrors[r] = juce::jmax (staticErrors[r], error);
+
+                if (resolutions[r] != GainCurve::Resolution::exact)
+                    continue;
+
+                const auto failed = error > staticToleranceDb;
+                staticFailures += failed ? 1 : 0;
+
+                if (failed || verbose)
+                    std::cout << (failed ? "FAIL static  " : "ok   static  ") << juce::String (error, 4) << " dB  " << point.toString() << std::endl;
+            }
+        }
+    }
+
+    // Dynamic, exact engine against the reference on program-like material
+    {
+        juce::AudioBuffer<float> input (2, (int) (sampleRate * seconds)), reference, output;
+        fillTestSignal (input, sampleRate);
+
+        for (const auto& point : makeGrid (false))
+        {
+            punk_dsp::Lifter lifter;
+            prepare (lifter, point, sampleRate, 2);
+            reference.makeCopyOf (input);
+            render (lifter, reference);
+
+            LifterEngine engine;
+            prepare (engine, point, sampleRate, 2);
+            output.makeCopyOf (input);
+            render (engine, output);
+
+            const auto error = maxGainDifferenceDb (input, output, reference);
+            const auto failed = error > dynamicToleranceDb;
+            worstDynamic = juce::jmax (worstDynamic, error);
+            dynamicFailures += failed ? 1 : 0;
+
+            if (failed || verbose)
+                std::cout << (failed ? "FAIL dynamic " : "ok   dynamic ") << juce::String (error, 4) << " dB  " << point.toString() << std::endl;
+        }
+    }
+
+    std::cout << std::endl << "Static curve, max difference to punk_dsp::Lifter:" << std::endl;
+
+    for (size_t r = 0; r < resolutions.size(); ++r)
+        std::cout << "  " << juce::String (Parameters::curveChoices[(int) resolutions[r]]).paddedRight (' ', 8)
+                  << juce::String (staticErrors[r], 4) << " dB" << (resolutions[r] == GainCurve::Resolution::exact ? "  (tolerance " + juce::String (staticToleranceDb) + " dB)" : juce::String()) << std::endl;
+
+    std::cout << "Dynamic, max difference to punk_dsp::Lifter: " << juce::String (worstDynamic, 4) << " dB (tolerance " << dynamicToleranceDb << " dB)" << std::endl;
+
+    const auto failures = staticFailures + dynamicFailures;
+    std::cout << (failures == 0 ? "PASS" : "FAIL") << ": " << failures << " grid points outside the tolerance" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
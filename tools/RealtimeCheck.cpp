@@ -0,0 +1,577 @@
+// Realtime safety check: runs LifterProcessor and the bare punk_dsp::Lifter with allocation,
+// lock and blocking system call hooks armed around everything the audio thread does.
+//
+// Usage:
+//   LifterRealtimeCheck [--blocks=<n>] [--no-editor] [--max-reports=<n>]
+//
+//   --blocks=<n>        Blocks per scenario (default: 2000)
+//   --no-editor         Skip opening and closing editors, e.g. on a machine without a display
+//   --max-reports=<n>   Stack traces printed before only counting (default: 10)
+//
+// prepareToPlay, parameter changes from the message thread and editor open/close run unarmed,
+// as a host runs them. Anything the audio thread does while armed, processBlock, parameter
+// changes a host sends on the audio thread, clap_direct_process with its parameter events and
+// the bare Lifter's update* and process calls, must not allocate, free, lock or block. Every
+// violation is reported with a stack trace and makes the run exit with 1.
+//
+// One lock is let through: JUCE's AudioProcessorParameter notifies its listeners under an
+// uncontended mutex, and every JUCE wrapper (and the CLAP direct path, which does what the
+// wrapper would) takes it on the audio thread when a parameter changes there. It is only
+// allowed around those changes and around clap_direct_process. The processBlock scenarios
+// check the processing itself for locks.
+//
+// Every scenario cycles through block sizes up to 16x the prepared size, toggles the topology
+// (feed-forward/back, curve, link, eco, bands) and moves the continuous parameters, half of
+// the changes from the message thread and half from the audio thread. Scenarios run in stereo,
+// except two at Parameters::maxChannels, where the engine's multichannel path and the
+// per-channel views are at their largest.
+//
+// Global operator new/delete are replaced on every platform. On Linux the C allocator, pthread
+// locks and the blocking calls below are interposed as well, so allocations and locks inside
+// JUCE and punk_dsp are caught too. Hooks only fire on a thread that armed them, so the
+// background and worker threads keep allocating freely.
+
+#include "PluginProcessor.h"
+
+#include <cerrno>
+#include <iostream>
+
+#if JUCE_LINUX
+    #include <dlfcn.h>
+    #include <pthread.h>
+    #include <semaphore.h>
+    #include <sched.h>
+    #include <unistd.h>
+#endif
+
+namespace RealtimeGuard
+{
+    // Constant-initialised, so reading it from the allocator hooks never allocates
+    thread_local bool armed = false;
+
+    std::atomic<int> numViolations { 0 };
+    int maxReports = 10;
+
+    void report (const char* what)
+    {
+        if (! armed)
+            return;
+
+        // The report allocates and writes, so the guard is off while it runs
+        armed = false;
+
+        if (numViolations++ < maxReports)
+            std::cerr << std::endl << "Realtime violation: " << what << " on the audio thread" << std::endl
+                      << juce::SystemStats::getStackBacktrace() << std::flush;
+
+        armed = true;
+    }
+
+    // Marks the current thread as the audio thread for its lifetime
+    struct ScopedAudioThread
+    {
+        ScopedAudioThread() noexcept { armed = true; }
+        ~ScopedAudioThread() noexcept { armed = false; }
+    };
+
+    // Set while JUCE's parameter plumbing runs on the audio thread on the host's behalf
+    thread_local bool inHostParameterChange = false;
+
+    // Lets pthread_mutex_lock through for its lifetime, for the lock JUCE takes to notify
+    // parameter listeners. Allocations and blocking calls are still reported.
+    struct ScopedHostParameterChange
+    {
+        ScopedHostParameterChange() noexcept { inHostParameterChange = true; }
+        ~ScopedHostParameterChange() noexcept { inHostParameterChange = false; }
+    };
+}
+
+//==============================================================================
+// Allocator hooks. glibc exports its allocator under __libc_* names, so the interposed
+// malloc family can forward to it without going through dlsym, which allocates itself.
+#if JUCE_LINUX
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void* __libc_memalign (size_t, size_t);
+    void __libc_free (void*);
+
+    void* malloc (size_t size)                   { RealtimeGuard::report ("malloc"); return __libc_malloc (size); }
+    void* calloc (size_t count, size_t size)     { RealtimeGuard::report ("calloc"); return __libc_calloc (count, size); }
+    void* realloc (void* ptr, size_t size)       { RealtimeGuard::report ("realloc"); return __libc_realloc (ptr, size); }
+    void* aligned_alloc (size_t align, size_t size) { RealtimeGuard::report ("aligned_alloc"); return __libc_memalign (align, size); }
+
+    int posix_memalign (void** ptr, size_t align, size_t size)
+    {
+        RealtimeGuard::report ("posix_memalign");
+        *ptr = __libc_memalign (align, size);
+        return *ptr != nullptr ? 0 : ENOMEM;
+    }
+
+    void free (void* ptr)
+    {
+        if (ptr != nullptr)
+            RealtimeGuard::report ("free");
+
+        __libc_free (ptr);
+    }
+}
+
+namespace
+{
+    void* rawAlloc (size_t size)                  { return __libc_malloc (size); }
+    void* rawAlignedAlloc (size_t align, size_t size) { return __libc_memalign (align, size); }
+    void rawFree (void* ptr)                      { __libc_free (ptr); }
+}
+#else
+namespace
+{
+    void* rawAlloc (size_t size) { return std::malloc (size); }
+
+    // Over-allocates and keeps the original pointer just before the aligned block
+    void* rawAlignedAlloc (size_t align, size_t size)
+    {
+        auto* base = static_cast<char*> (std::malloc (size + align + sizeof (void*)));
+
+        if (base == nullptr)
+            return nullptr;
+
+        auto* aligned = reinterpret_cast<void**> (juce::snapPointerToAlignment (base + sizeof (void*), align));
+        aligned[-1] = base;
+        return aligned;
+    }
+
+    void rawFree (void* ptr) { std::free (ptr); }
+    void rawAlignedFree (void* ptr) { if (ptr != nullptr) std::free (static_cast<void**> (ptr)[-1]); }
+}
+#endif
+
+void* operator new (std::size_t size)
+{
+    RealtimeGuard::report ("operator new");
+
+    if (auto* ptr = rawAlloc (size != 0 ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new (std::size_t size, std::align_val_t align)
+{
+    RealtimeGuard::report ("operator new");
+
+    if (auto* ptr = rawAlignedAlloc ((size_t) align, size != 0 ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)                        { return operator new (size); }
+void* operator new[] (std::size_t size, std::align_val_t align) { return operator new (size, align); }
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept   { RealtimeGuard::report ("operator new"); return rawAlloc (size != 0 ? size : 1); }
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept { RealtimeGuard::report ("operator new"); return rawAlloc (size != 0 ? size : 1); }
+
+void operator delete (void* ptr) noexcept
+{
+    if (ptr != nullptr)
+        RealtimeGuard::report ("operator delete");
+
+    rawFree (ptr);
+}
+
+void operator delete (void* ptr, std::align_val_t) noexcept
+{
+    if (ptr != nullptr)
+        RealtimeGuard::report ("operator delete");
+
+   #if JUCE_LINUX
+    rawFree (ptr);
+   #else
+    rawAlignedFree (ptr);
+   #endif
+}
+
+void operator delete[] (void* ptr) noexcept                                      { operator delete (ptr); }
+void operator delete[] (void* ptr, std::align_val_t align) noexcept              { operator delete (ptr, align); }
+void operator delete (void* ptr, std::size_t) noexcept                           { operator delete (ptr); }
+void operator delete[] (void* ptr, std::size_t) noexcept                         { operator delete (ptr); }
+void operator delete (void* ptr, std::size_t, std::align_val_t align) noexcept   { operator delete (ptr, align); }
+void operator delete[] (void* ptr, std::size_t, std::align_val_t align) noexcept { operator delete (ptr, align); }
+
+//==============================================================================
+// Lock and blocking call hooks, forwarding to the next definition in link order.
+// The real functions are looked up on first use, since other static constructors may
+// already lock before ours run. Each slot is constant-initialised, so there is no guard.
+#if JUCE_LINUX
+namespace
+{
+    template <typename Function>
+    Function findNext (std::atomic<void*>& slot, const char* name)
+    {
+        auto* function = slot.load (std::memory_order_acquire);
+
+        if (function == nullptr)
+        {
+            function = dlsym (RTLD_NEXT, name);
+            slot.store (function, std::memory_order_release);
+        }
+
+        return reinterpret_cast<Function> (function);
+    }
+}
+
+// allowedForHost: let through inside a ScopedHostParameterChange
+#define LIFTER_REALTIME_HOOK(allowedForHost, returnType, name, params, args)   \
+    extern "C" returnType name params                                          \
+    {                                                                          \
+        static std::atomic<void*> next { nullptr };                            \
+        if (! (allowedForHost && RealtimeGuard::inHostParameterChange))        \
+            RealtimeGuard::report (#name);                                     \
+        return findNext<returnType (*) params> (next, #name) args;             \
+    }
+
+LIFTER_REALTIME_HOOK (true,  int, pthread_mutex_lock, (pthread_mutex_t* mutex), (mutex))
+LIFTER_REALTIME_HOOK (false, int, pthread_rwlock_rdlock, (pthread_rwlock_t* lock), (lock))
+LIFTER_REALTIME_HOOK (false, int, pthread_rwlock_wrlock, (pthread_rwlock_t* lock), (lock))
+LIFTER_REALTIME_HOOK (false, int, pthread_cond_wait, (pthread_cond_t* cond, pthread_mutex_t* mutex), (cond, mutex))
+LIFTER_REALTIME_HOOK (false, int, pthread_cond_timedwait, (pthread_cond_t* cond, pthread_mutex_t* mutex, const timespec* time), (cond, mutex, time))
+LIFTER_REALTIME_HOOK (false, int, sem_wait, (sem_t* sem), (sem))
+LIFTER_REALTIME_HOOK (false, int, nanosleep, (const timespec* time, timespec* remaining), (time, remaining))
+LIFTER_REALTIME_HOOK (false, int, usleep, (useconds_t time), (time))
+LIFTER_REALTIME_HOOK (false, int, sched_yield, (), ())
+LIFTER_REALTIME_HOOK (false, ssize_t, read, (int fd, void* data, size_t size), (fd, data, size))
+LIFTER_REALTIME_HOOK (false, ssize_t, write, (int fd, const void* data, size_t size), (fd, data, size))
+
+#undef LIFTER_REALTIME_HOOK
+#endif
+
+//==============================================================================
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int preparedBlockSize = 256;
+    constexpr int numChannels = 2;
+
+    // Includes sizes above the prepared one, which hosts send more often than they should
+    constexpr std::array blockSizes { preparedBlockSize, 1, 17, 64, preparedBlockSize * 2 + 3, preparedBlockSize * 16 };
+
+    constexpr std::array continuousIds { Parameters::ratioId, Parameters::thresId, Parameters::kneeId, Parameters::attackId,
+                                         Parameters::releaseId, Parameters::makeupId, Parameters::mixId };
+    constexpr std::array topologyIds { Parameters::feedId, Parameters::curveId, Parameters::linkId, Parameters::ecoId, Parameters::truePeakId, Parameters::bandsId };
+
+    struct Options
+    {
+        int numBlocks = 2000;
+        bool withEditor = true;
+    };
+
+    struct Scenario
+    {
+        const char* name;
+        std::vector<std::pair<const char*, float>> settings;
+        bool doublePrecision = false;
+        int numChannels = 2;
+    };
+
+    void fillNoise (juce::AudioBuffer<float>& buffer, juce::Random& random)
+    {
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample (ch, i, 0.5f * (random.nextFloat() * 2.0f - 1.0f));
+    }
+
+    // Changes from the message thread, as the editor and some hosts send them
+    void setParameter (LifterProcessor& processor, const char* id, float normalisedValue)
+    {
+        if (auto* parameter = processor.apvts.getParameter (id))
+            parameter->setValueNotifyingHost (normalisedValue);
+    }
+
+    // Changes from the audio thread, right before the block they belong to, the way JUCE's
+    // wrappers apply host automation. Called armed.
+    void setParameterFromAudioThread (LifterProcessor& processor, const char* id, float normalisedValue)
+    {
+        if (auto* parameter = processor.apvts.getParameter (id))
+        {
+            const RealtimeGuard::ScopedHostParameterChange hostChange;
+            parameter->setValue (normalisedValue);
+            parameter->sendValueChangedMessageToListeners (normalisedValue);
+        }
+    }
+
+    template <size_t size>
+    const char* pickId (const std::array<const char*, size>& ids, juce::Random& random)
+    {
+        return ids[(size_t) random.nextInt ((int) size)];
+    }
+
+    template <typename SampleType>
+    void runProcessor (LifterProcessor& processor, int channels, const Options& options, juce::Random& random)
+    {
+        juce::AudioBuffer<float> source (channels, preparedBlockSize * 16);
+        fillNoise (source, random);
+
+        juce::AudioBuffer<SampleType> buffer (channels, source.getNumSamples());
+        juce::MidiBuffer midi;
+        std::unique_ptr<juce::AudioProcessorEditor> editor;
+
+        for (int block = 0; block < options.numBlocks; ++block)
+        {
+            // Host side work between callbacks, unarmed
+            if (block % 14 == 0)
+                setParameter (processor, pickId (continuousIds, random), random.nextFloat());
+            if (block % 106 == 0)
+                setParameter (processor, pickId (topologyIds, random), random.nextFloat());
+            if (options.withEditor && block % 97 == 0)
+                editor.reset (editor == nullptr ? processor.createEditor() : nullptr);
+
+            const auto numSamples = blockSizes[(size_t) block % blockSizes.size()];
+            juce::AudioBuffer<SampleType> view (buffer.getArrayOfWritePointers(), channels, 0, numSamples);
+
+            for (int ch = 0; ch < channels; ++ch)
+                for (int i = 0; i < numSamples; ++i)
+                    view.setSample (ch, i, (SampleType) source.getSample (ch, i));
+
+            const RealtimeGuard::ScopedAudioThread audioThread;
+
+            if (block % 14 == 7)
+                setParameterFromAudioThread (processor, pickId (continuousIds, random), random.nextFloat());
+            if (block % 106 == 53)
+                setParameterFromAudioThread (processor, pickId (topologyIds, random), random.nextFloat());
+
+            processor.processBlock (view, midi);
+        }
+    }
+
+    // Stereo, or a discrete layout of that many channels
+    bool prepareLayout (LifterProcessor& processor, bool doublePrecision, int channels)
+    {
+        const auto channelSet = channels == 2 ? juce::AudioChannelSet::stereo() : juce::AudioChannelSet::discreteChannels (channels);
+
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add (channelSet);
+        layout.outputBuses.add (channelSet);
+
+        if (! processor.setBusesLayout (layout))
+            return false;
+
+        processor.setProcessingPrecision (doublePrecision ? juce::AudioProcessor::doublePrecision : juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails (sampleRate, preparedBlockSize);
+        processor.prepareToPlay (sampleRate, preparedBlockSize);
+        return true;
+    }
+
+    bool runProcessorScenario (const Scenario& scenario, const Options& options)
+    {
+        juce::Random random (7);
+        LifterProcessor processor;
+
+        for (const auto& [id, value] : scenario.settings)
+            if (auto* parameter = processor.apvts.getParameter (id))
+                parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+
+        if (! prepareLayout (processor, scenario.doublePrecision, scenario.numChannels))
+            return false;
+
+        if (scenario.doublePrecision)
+            runProcessor<double> (processor, scenario.numChannels, options, random);
+        else
+            runProcessor<float> (processor, scenario.numChannels, options, random);
+
+        processor.releaseResources();
+        return true;
+    }
+
+    // Events of one block, handed to the processor through clap_input_events
+    struct EventList
+    {
+        static constexpr int maxEvents = 4;
+        std::array<clap_event_param_value, maxEvents> events {};
+        juce::uint32 numEvents = 0;
+
+        clap_input_events getInterface()
+        {
+            return { this,
+                     [] (const clap_input_events* list) { return static_cast<const EventList*> (list->ctx)->numEvents; },
+                     [] (const clap_input_events* list, juce::uint32 index)
+                     {
+                         return &static_cast<const EventList*> (list->ctx)->events[index].header;
+                     } };
+        }
+    };
+
+    // A CLAP host calls clap_direct_process with the block's parameter events, which the
+    // processor applies at their sample offsets, all on the audio thread. Even blocks run in
+    // place, odd ones with separate input and output buffers.
+    bool runClapScenario (const Options& options)
+    {
+        juce::Random random (13);
+        LifterProcessor processor;
+
+        if (! prepareLayout (processor, false, numChannels))
+            return false;
+
+        std::array<clap_id, continuousIds.size() + topologyIds.size()> paramIds {};
+        for (size_t i = 0; i < paramIds.size(); ++i)
+            paramIds[i] = (clap_id) juce::String (i < continuousIds.size() ? continuousIds[i] : topologyIds[i - continuousIds.size()]).hashCode();
+
+        juce::AudioBuffer<float> source (numChannels, preparedBlockSize * 16), input (numChannels, source.getNumSamples()), output (numChannels, source.getNumSamples());
+        fillNoise (source, random);
+
+        EventList eventList;
+        const auto inEvents = eventList.getInterface();
+
+        for (int block = 0; block < options.numBlocks; ++block)
+        {
+            const auto numSamples = blockSizes[(size_t) block % blockSizes.size()];
+            const auto inPlace = block % 2 == 0;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                (inPlace ? output : input).copyFrom (ch, 0, source, ch, 0, numSamples);
+
+            // Sorted offsets, topology changes only now and then, as automation sends them
+            std::array<juce::uint32, EventList::maxEvents> times {};
+            eventList.numEvents = (juce::uint32) random.nextInt (EventList::maxEvents + 1);
+
+            for (juce::uint32 e = 0; e < eventList.numEvents; ++e)
+                times[e] = (juce::uint32) random.nextInt (numSamples);
+
+            std::sort (times.begin(), times.begin() + eventList.numEvents);
+
+            for (juce::uint32 e = 0; e < eventList.numEvents; ++e)
+            {
+                const auto param = block % 20 == 0 ? continuousIds.size() + (size_t) random.nextInt ((int) topologyIds.size())
+                                                   : (size_t) random.nextInt ((int) continuousIds.size());
+
+                auto& event = eventList.events[e];
+                event.header = { sizeof (clap_event_param_value), times[e], CLAP_CORE_EVENT_SPACE_ID, CLAP_EVENT_PARAM_VALUE, 0 };
+                event.param_id = paramIds[param];
+                event.cookie = nullptr;
+                event.note_id = event.port_index = event.channel = event.key = -1;
+                event.value = random.nextDouble();
+            }
+
+            clap_audio_buffer inputBuffer {}, outputBuffer {};
+            inputBuffer.data32 = (inPlace ? output : input).getArrayOfWritePointers();
+            inputBuffer.channel_count = numChannels;
+            outputBuffer.data32 = output.getArrayOfWritePointers();
+            outputBuffer.channel_count = numChannels;
+
+            clap_process process {};
+            process.frames_count = (juce::uint32) numSamples;
+            process.audio_inputs = &inputBuffer;
+            process.audio_outputs = &outputBuffer;
+            process.audio_inputs_count = 1;
+            process.audio_outputs_count = 1;
+            process.in_events = &inEvents;
+
+            // applyParameterEvent keeps the JUCE parameters in step as the wrapper would
+            const RealtimeGuard::ScopedAudioThread audioThread;
+            const RealtimeGuard::ScopedHostParameterChange hostChange;
+            processor.clap_direct_process (&process);
+        }
+
+        processor.releaseResources();
+        return true;
+    }
+
+    // The bare Lifter has no parameter plumbing, so its update* calls run armed like process()
+    void runBareLifter (const Options& options)
+    {
+        juce::Random random (11);
+        punk_dsp::Lifter lifter;
+        lifter.prepare ({ sampleRate, (juce::uint32) preparedBlockSize, (juce::uint32) numChannels });
+
+        juce::AudioBuffer<float> source (numChannels, preparedBlockSize * 16), buffer (numChannels, preparedBlockSize * 16);
+        fillNoise (source, random);
+
+        for (int block = 0; block < options.numBlocks; ++block)
+        {
+            const auto numSamples = blockSizes[(size_t) block % blockSizes.size()];
+            juce::AudioBuffer<float> view (buffer.getArrayOfWritePointers(), numChannels, 0, numSamples);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                view.copyFrom (ch, 0, source, ch, 0, numSamples);
+
+            const RealtimeGuard::ScopedAudioThread audioThread;
+
+            if (block % 7 == 0)
+            {
+                lifter.updateRatio (juce::jmap (random.nextFloat(), Parameters::ratioMin, Parameters::ratioMax));
+                lifter.updateRange (juce::jmap (random.nextFloat(), Parameters::thresMin, Parameters::thresMax));
+                lifter.updateKnee (juce::jmap (random.nextFloat(), Parameters::kneeMin, Parameters::kneeMax));
+                lifter.updateAttack (juce::jmap (random.nextFloat(), Parameters::attackMin, Parameters::attackMax));
+                lifter.updateRelease (juce::jmap (random.nextFloat(), Parameters::releaseMin, Parameters::releaseMax));
+                lifter.updateMakeUp (juce::jmap (random.nextFloat(), Parameters::makeupMin, Parameters::makeupMax));
+                lifter.updateMix (juce::jmap (random.nextFloat(), Parameters::mixMin, Parameters::mixMax));
+            }
+
+            if (block % 53 == 0)
+                lifter.updateFeedForward (random.nextBool());
+
+            lifter.process (view);
+        }
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args (argc, argv);
+
+    Options options;
+    if (args.containsOption ("--blocks"))
+        options.numBlocks = juce::jmax (1, args.getValueForOption ("--blocks").getIntValue());
+    if (args.containsOption ("--max-reports"))
+        RealtimeGuard::maxReports = juce::jmax (0, args.getValueForOption ("--max-reports").getIntValue());
+    options.withEditor = ! args.containsOption ("--no-editor");
+
+    const std::vector<Scenario> scenarios {
+        { "default", {} },
+        { "feed-back", { { Parameters::feedId, 0.0f } } },
+        { "curve table", { { Parameters::curveId, 2.0f } } },
+        { "linked", { { Parameters::linkId, 1.0f } } },
+        { "eco", { { Parameters::ecoId, 2.0f } } },
+        { "true peak", { { Parameters::truePeakId, 2.0f } } },
+        { "multiband", { { Parameters::bandsId, 3.0f } } },
+        { "double precision", {}, true },
+        { "max channels", {}, false, Parameters::maxChannels },
+        { "max channels, multiband", { { Parameters::bandsId, 3.0f } }, false, Parameters::maxChannels },
+    };
+
+    for (const auto& scenario : scenarios)
+    {
+        const auto before = RealtimeGuard::numViolations.load();
+
+        if (! runProcessorScenario (scenario, options))
+        {
+            std::cerr << "Could not set up scenario " << scenario.name << std::endl;
+            return 1;
+        }
+
+        std::cout << "processor, " << scenario.name << ": " << RealtimeGuard::numViolations.load() - before << " violations" << std::endl;
+    }
+
+    {
+        const auto before = RealtimeGuard::numViolations.load();
+
+        if (! runClapScenario (options))
+        {
+            std::cerr << "Could not set up the CLAP scenario" << std::endl;
+            return 1;
+        }
+
+        std::cout << "processor, CLAP direct process: " << RealtimeGuard::numViolations.load() - before << " violations" << std::endl;
+    }
+
+    const auto before = RealtimeGuard::numViolations.load();
+    runBareLifter (options);
+    std::cout << "punk_dsp::Lifter: " << RealtimeGuard::numViolations.load() - before << " violations" << std::endl;
+
+    const auto total = RealtimeGuard::numViolations.load();
+    std::cout << (total == 0 ? "PASS" : "FAIL") << ": " << total << " realtime violations" << std::endl;
+    return total == 0 ? 0 : 1;
+}